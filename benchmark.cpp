@@ -0,0 +1,452 @@
+#include <set>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <sys/resource.h>
+#include "dualization.h"
+
+using namespace std;
+
+/**
+ * Benchmark of the engines on random matrices. L1 has shape (rows, cols) and
+ * L2 has shape (rows2, cols); both are generated in memory from the seed, so
+ * a case is reproduced exactly by its parameters. Every case is run warmup
+ * times without being measured and then repeat times. combine and exist
+ * dualize both matrices and join the coverages with exist off and on; their
+ * nodes are those of the two dualizations.
+ *
+ * A case of a batch of jobs > 0 is run by batch_dualization on jobs matrices
+ * or pairs, job k of them generated from seed + 2k and seed + 2k + 1, and
+ * only counts the results.
+ */
+struct BenchmarkCase {
+    string engine;
+    size_t rows, cols, rows2;
+    double density;
+    ull seed;
+    size_t jobs;
+};
+
+struct BenchmarkResult {
+    BenchmarkCase params;
+    size_t nodes;
+    size_t results;
+    /*! Wall times of the measured runs, in seconds*/
+    vector<double> seconds;
+    /*! Peak resident set size of the case in KiB*/
+    long peak_rss;
+    /*! Statistics of the last run as JSON, empty unless asked for*/
+    string stats;
+    /*! Whether the check of the counts failed*/
+    bool mismatch;
+
+    double best() const {
+        return *min_element(seconds.begin(), seconds.end());
+    }
+
+    double median() const {
+        vector<double> sorted = seconds;
+        sort(sorted.begin(), sorted.end());
+        size_t k = sorted.size() / 2;
+        return sorted.size() % 2 ? sorted[k] : (sorted[k - 1] + sorted[k]) / 2;
+    }
+
+    double mean() const {
+        double sum = 0;
+        for (double s: seconds) sum += s;
+        return sum / seconds.size();
+    }
+
+    double nodes_per_second() const {
+        return median() > 0 ? nodes / median() : 0;
+    }
+
+    double jobs_per_second() const {
+        return median() > 0 ? max<size_t>(params.jobs, 1) / median() : 0;
+    }
+};
+
+const char *ENGINES[] = {"dual", "combine", "exist", "d1", "d2"};
+
+/**
+ * Resets the peak resident set size of the process, so that every case
+ * reports its own peak. Linux only; elsewhere the peak of the whole run is
+ * reported.
+ */
+void reset_peak_rss() {
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (f == nullptr) return;
+    fputs("5", f);
+    fclose(f);
+}
+
+long peak_rss() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return strtol(line.c_str() + 6, nullptr, 10);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/*! Runs the engine of a case once. Sets the number of nodes and of results*/
+void run_case(const BenchmarkCase &c, PartialBitMatrix &L1, PartialBitMatrix &L2,
+              BranchingStrategy &strategy, size_t threads,
+              SearchControl &control, size_t &nodes, size_t &results) {
+    CountVisitor counter;
+    control.reset();
+    if (c.engine == "dual") {
+        nodes = dualization(L1, counter, strategy, threads, &control);
+    } else if (c.engine == "d1") {
+        nodes = D1_dualization(L1, L2, counter, strategy, threads, &control);
+    } else if (c.engine == "d2") {
+        nodes = D2_dualization(L1, L2, counter, strategy, threads, &control);
+    } else {
+        CoverageStore cov1, cov2;
+        SaveVisitor save1(&cov1, nullptr), save2(&cov2, nullptr);
+        nodes = dualization(L1, save1, strategy, threads, &control);
+        nodes += dualization(L2, save2, strategy, threads, &control);
+        combine(cov1, cov2, counter, c.engine == "exist");
+    }
+    results = counter.count;
+}
+
+/*! Runs the batch of a case once. Sets the total numbers of nodes and results*/
+void run_batch_case(const BenchmarkCase &c, const vector<PartialBitMatrix> &matrices,
+                    const vector<pair<PartialBitMatrix, PartialBitMatrix>> &pairs,
+                    BranchingStrategy &strategy, size_t threads,
+                    SearchControl &control, size_t &nodes, size_t &results) {
+    vector<BatchResult> batch;
+    control.reset();
+    if (c.engine == "dual") {
+        batch = batch_dualization(matrices, strategy, threads, false, &control);
+    } else {
+        batch = batch_dualization(pairs, c.engine == "d1" ? ENGINE_D1 : ENGINE_D2,
+                                  strategy, threads, false, &control);
+    }
+    nodes = results = 0;
+    for (auto &result: batch) {
+        nodes += result.nodes;
+        results += (size_t) result.count;
+    }
+}
+
+/**
+ * Checks that the engine of a case finds every result once: results, the
+ * count of the measured runs, has to equal the number of distinct results
+ * saved by a run with a SaveVisitor and, for dual and d1, the count of
+ * dualization_count and D1_count. Prints the counts that differ.
+ */
+bool check_counts(const BenchmarkCase &c, PartialBitMatrix &L1, PartialBitMatrix &L2,
+                  BranchingStrategy &strategy, size_t threads, size_t results) {
+    CoverageStore coverages;
+    set<pair<set<size_t>, set<size_t>>> found;
+    SaveVisitor saver(&coverages, &found);
+    size_t distinct = 0;
+    count_t counted = results;
+    if (c.engine == "dual") {
+        dualization(L1, saver, strategy, threads);
+        distinct = coverages.size();
+        counted = dualization_count(L1, strategy, threads);
+    } else if (c.engine == "d1") {
+        D1_dualization(L1, L2, saver, strategy, threads);
+        distinct = found.size();
+        counted = D1_count(L1, L2, strategy, nullptr, nullptr, threads);
+    } else if (c.engine == "d2") {
+        D2_dualization(L1, L2, saver, strategy, threads);
+        distinct = found.size();
+    } else {
+        return true;
+    }
+    if (distinct == results && counted == results) return true;
+    cerr << "Counts of " << c.engine << " differ: " << results << " found, "
+         << distinct << " distinct, " << (unsigned long long) counted << " counted"
+         << endl;
+    return false;
+}
+
+/**
+ * Runs a case warmup + repeat times. progress, if given, prints the progress
+ * of every run. With stats set the statistics of the last run are kept, with
+ * check set the counts of a case that is not a batch are checked.
+ * Only the matrices the engine of the case reads are generated.
+ */
+BenchmarkResult measure(const BenchmarkCase &c, size_t warmup, size_t repeat,
+                        size_t threads, SearchProgress *progress, bool stats,
+                        bool check) {
+    PartialBitMatrix L1, L2;
+    if (!c.jobs) {
+        L1 = PartialBitMatrix(c.rows, c.cols, c.density, c.seed);
+        if (c.engine != "dual")
+            L2 = PartialBitMatrix(c.rows2, c.cols, c.density, c.seed + 1);
+    }
+    vector<PartialBitMatrix> matrices;
+    vector<pair<PartialBitMatrix, PartialBitMatrix>> pairs;
+    for (size_t k = 0; k < c.jobs; k++) {
+        PartialBitMatrix A(c.rows, c.cols, c.density, c.seed + 2 * k);
+        if (c.engine == "dual") {
+            matrices.push_back(A);
+            continue;
+        }
+        pairs.emplace_back(A, PartialBitMatrix(c.rows2, c.cols, c.density,
+                                               c.seed + 2 * k + 1));
+    }
+    LightestRowStrategy strategy;
+    SearchControl control;
+    SearchProfile profile;
+    BenchmarkResult result;
+    result.params = c;
+    result.mismatch = false;
+    control.setProgress(progress);
+    reset_peak_rss();
+    for (size_t k = 0; k < warmup + repeat; k++) {
+        if (stats && k + 1 == warmup + repeat) control.setProfile(&profile);
+        if (progress) progress->restart();
+        auto start = chrono::steady_clock::now();
+        if (c.jobs) run_batch_case(c, matrices, pairs, strategy, threads, control,
+                                   result.nodes, result.results);
+        else run_case(c, L1, L2, strategy, threads, control, result.nodes,
+                      result.results);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        if (k >= warmup) result.seconds.push_back(elapsed.count());
+    }
+    result.peak_rss = peak_rss();
+    if (check && !c.jobs)
+        result.mismatch = !check_counts(c, L1, L2, strategy, threads, result.results);
+    if (stats) {
+        ostringstream json;
+        json << setprecision(9);
+        profile.write_json(json);
+        result.stats = json.str();
+    }
+    return result;
+}
+
+void print_text(const vector<BenchmarkResult> &results, ostream &out) {
+    out << left << setw(9) << "engine" << right << setw(14) << "shape"
+        << setw(9) << "density" << setw(8) << "seed" << setw(12) << "nodes"
+        << setw(12) << "results" << setw(11) << "median s" << setw(11)
+        << "best s" << setw(13) << "nodes/s" << setw(11) << "jobs/s"
+        << setw(11) << "peak KiB" << endl;
+    for (auto &r: results) {
+        ostringstream shape;
+        shape << r.params.rows << "x" << r.params.cols;
+        if (r.params.engine != "dual") shape << "x" << r.params.rows2;
+        out << left << setw(9) << r.params.engine << right << setw(14)
+            << shape.str() << setw(9) << setprecision(2) << fixed
+            << r.params.density << setw(8) << r.params.seed << setw(12)
+            << r.nodes << setw(12) << r.results << setprecision(4)
+            << setw(11) << r.median() << setw(11) << r.best()
+            << setprecision(0) << setw(13) << r.nodes_per_second()
+            << setw(11) << r.jobs_per_second() << setw(11) << r.peak_rss << endl;
+    }
+}
+
+void print_csv(const vector<BenchmarkResult> &results, const string &label,
+               size_t threads, ostream &out) {
+    out << "label,engine,rows,cols,rows2,density,seed,jobs,threads,nodes,results,"
+           "runs,median_s,best_s,mean_s,nodes_per_s,jobs_per_s,peak_rss_kib" << endl;
+    out << setprecision(9);
+    for (auto &r: results) {
+        out << label << ',' << r.params.engine << ',' << r.params.rows << ','
+            << r.params.cols << ',' << r.params.rows2 << ','
+            << r.params.density << ',' << r.params.seed << ',' << r.params.jobs
+            << ',' << threads << ',' << r.nodes << ',' << r.results << ',' << r.seconds.size()
+            << ',' << r.median() << ',' << r.best() << ',' << r.mean() << ','
+            << r.nodes_per_second() << ',' << r.jobs_per_second() << ','
+            << r.peak_rss << endl;
+    }
+}
+
+string json_string(const string &text) {
+    string quoted = "\"";
+    for (char ch: text) {
+        if (ch == '"' || ch == '\\') quoted += '\\';
+        if ((unsigned char) ch < ' ') continue;
+        quoted += ch;
+    }
+    return quoted + "\"";
+}
+
+void print_json(const vector<BenchmarkResult> &results, const string &label,
+                size_t threads, size_t warmup, ostream &out) {
+    out << setprecision(9);
+    out << "{" << endl;
+    out << "  \"label\": " << json_string(label) << "," << endl;
+    out << "  \"threads\": " << threads << "," << endl;
+    out << "  \"warmup\": " << warmup << "," << endl;
+    out << "  \"results\": [";
+    for (size_t k = 0; k < results.size(); k++) {
+        const BenchmarkResult &r = results[k];
+        out << (k ? "," : "") << endl << "    {\"engine\": "
+            << json_string(r.params.engine) << ", \"rows\": " << r.params.rows
+            << ", \"cols\": " << r.params.cols << ", \"rows2\": "
+            << r.params.rows2 << ", \"density\": " << r.params.density
+            << ", \"seed\": " << r.params.seed << ", \"jobs\": " << r.params.jobs
+            << ", \"nodes\": " << r.nodes
+            << ", \"results\": " << r.results << ", \"seconds\": [";
+        for (size_t i = 0; i < r.seconds.size(); i++)
+            out << (i ? ", " : "") << r.seconds[i];
+        out << "], \"median_s\": " << r.median() << ", \"best_s\": "
+            << r.best() << ", \"mean_s\": " << r.mean()
+            << ", \"nodes_per_s\": " << r.nodes_per_second()
+            << ", \"jobs_per_s\": " << r.jobs_per_second()
+            << ", \"peak_rss_kib\": " << r.peak_rss;
+        if (!r.stats.empty()) out << ", \"stats\": " << r.stats;
+        out << "}";
+    }
+    out << endl << "  ]" << endl << "}" << endl;
+}
+
+vector<string> split_list(const string &text) {
+    vector<string> items;
+    stringstream in(text);
+    string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+void usage(const char *program) {
+    cerr << "Usage: " << program << " [options]" << endl
+         << "  --engines LIST     dual,combine,exist,d1,d2 (default: all)" << endl
+         << "  --shapes LIST      ROWSxCOLS[xROWS2],... (default: 10x10,15x15,20x20)" << endl
+         << "  --densities LIST   probabilities of 1 (default: 0.5)" << endl
+         << "  --seeds LIST       seeds of the matrices (default: 1)" << endl
+         << "  --warmup N         unmeasured runs of every case (default: 1)" << endl
+         << "  --repeat N         measured runs of every case (default: 3)" << endl
+         << "  --threads N        threads of every engine (default: 1)" << endl
+         << "  --batch N          run N instances of every case as one batch of jobs" << endl
+         << "                     on the threads (dual, d1 and d2 only)" << endl
+         << "  --format FORMAT    text, csv or json (default: text)" << endl
+         << "  --output FILE      write the report to FILE instead of stdout" << endl
+         << "  --label TEXT       copied to every csv and json record, e.g. a commit" << endl
+         << "  --stats            add the search statistics of every case to the json" << endl
+         << "                     output (needs a build with DUALIZATION_STATS)" << endl
+         << "  --progress SECONDS print a progress line to stderr every SECONDS" << endl
+         << "                     (needs a build with DUALIZATION_STATS)" << endl
+         << "  --check            check that the engines count every result once;" << endl
+         << "                     exits with 2 if a count differs (batches are not" << endl
+         << "                     checked)" << endl;
+}
+
+int main(int argc, char **argv) {
+    vector<string> engines(begin(ENGINES), end(ENGINES));
+    vector<string> shapes = {"10x10", "15x15", "20x20"};
+    vector<string> densities = {"0.5"};
+    vector<string> seeds = {"1"};
+    size_t warmup = 1, repeat = 3, threads = 1, jobs = 0;
+    string format = "text", output, label;
+    bool stats = false, check = false;
+    double progress_interval = 0;
+
+    for (int arg = 1; arg < argc; arg++) {
+        string option = argv[arg];
+        if (option == "--help" || option == "-h") {
+            usage(argv[0]);
+            return 0;
+        }
+        if (option == "--stats") {
+            stats = true;
+            continue;
+        }
+        if (option == "--check") {
+            check = true;
+            continue;
+        }
+        if (arg + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        string value = argv[++arg];
+        if (option == "--engines") engines = split_list(value);
+        else if (option == "--shapes") shapes = split_list(value);
+        else if (option == "--densities") densities = split_list(value);
+        else if (option == "--seeds") seeds = split_list(value);
+        else if (option == "--warmup") warmup = strtoul(value.c_str(), nullptr, 10);
+        else if (option == "--repeat") repeat = strtoul(value.c_str(), nullptr, 10);
+        else if (option == "--threads") threads = strtoul(value.c_str(), nullptr, 10);
+        else if (option == "--batch") jobs = strtoul(value.c_str(), nullptr, 10);
+        else if (option == "--format") format = value;
+        else if (option == "--output") output = value;
+        else if (option == "--label") label = value;
+        else if (option == "--progress") progress_interval = atof(value.c_str());
+        else {
+            cerr << "Unknown option: " << option << endl;
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (repeat == 0) repeat = 1;
+    if (format != "text" && format != "csv" && format != "json") {
+        cerr << "Unknown format: " << format << endl;
+        return 1;
+    }
+    for (auto &engine: engines) {
+        if (find(begin(ENGINES), end(ENGINES), engine) == end(ENGINES)) {
+            cerr << "Unknown engine: " << engine << endl;
+            return 1;
+        }
+        if (jobs && (engine == "combine" || engine == "exist")) {
+            cerr << "Engine " << engine << " does not run in batches" << endl;
+            return 1;
+        }
+    }
+
+    vector<BenchmarkCase> cases;
+    for (auto &shape: shapes) {
+        size_t rows = 0, cols = 0, rows2 = 0;
+        int fields = sscanf(shape.c_str(), "%zux%zux%zu", &rows, &cols, &rows2);
+        if (fields < 2) {
+            cerr << "Incorrect shape: " << shape << endl;
+            return 1;
+        }
+        if (fields == 2) rows2 = rows;
+        for (auto &density: densities)
+            for (auto &seed: seeds)
+                for (auto &engine: engines)
+                    cases.push_back({engine, rows, cols, rows2,
+                                     atof(density.c_str()),
+                                     strtoull(seed.c_str(), nullptr, 10), jobs});
+    }
+
+    unique_ptr<SearchProgress> progress;
+    if (progress_interval > 0) progress.reset(new SearchProgress(progress_interval));
+    vector<BenchmarkResult> results;
+    for (auto &c: cases) {
+        cerr << c.engine << " " << c.rows << "x" << c.cols << "x" << c.rows2
+             << " density " << c.density << " seed " << c.seed << endl;
+        results.push_back(measure(c, warmup, repeat, threads, progress.get(), stats,
+                                  check));
+    }
+
+    ofstream file;
+    if (!output.empty()) {
+        file.open(output);
+        if (!file) {
+            cerr << "Error: " << strerror(errno) << endl;
+            cerr << "Failed to open output file" << endl;
+            return 1;
+        }
+    }
+    ostream &out = output.empty() ? cout : file;
+    if (format == "csv") print_csv(results, label, threads, out);
+    else if (format == "json") print_json(results, label, threads, warmup, out);
+    else print_text(results, out);
+    for (auto &r: results)
+        if (r.mismatch) return 2;
+    return 0;
+}
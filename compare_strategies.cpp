@@ -0,0 +1,50 @@
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include "dualization.h"
+
+using namespace std;
+
+/**
+ * Runs an engine with every branching strategy on the same matrices and
+ * prints the node counts and times side by side.
+ */
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0]
+             << " dual|d1|d2 <matrix file> [<second matrix file>] [threads] [seed]"
+             << endl;
+        return 1;
+    }
+    string name = argv[1];
+    Engine engine;
+    if (name == "dual") engine = ENGINE_DUALIZATION;
+    else if (name == "d1") engine = ENGINE_D1;
+    else if (name == "d2") engine = ENGINE_D2;
+    else {
+        cerr << "Unknown engine: " << name << endl;
+        return 1;
+    }
+    int arg = 2;
+    PartialBitMatrix L1(argv[arg++]), L2;
+    if (engine != ENGINE_DUALIZATION) {
+        if (arg >= argc) {
+            cerr << "The engine needs a second matrix" << endl;
+            return 1;
+        }
+        L2 = PartialBitMatrix(argv[arg++]);
+    }
+    size_t threads = arg < argc ? strtoul(argv[arg++], nullptr, 10) : 1;
+    unsigned long long seed = arg < argc ? strtoull(argv[arg++], nullptr, 10) : 0;
+
+    FirstRowStrategy first;
+    LightestRowStrategy lightest;
+    FrequentColumnsStrategy frequent;
+    HardestToSupportStrategy hardest;
+    RandomRowStrategy random(seed);
+    print_reports(compare_strategies(L1, L2, engine,
+                                     {&first, &lightest, &frequent, &hardest, &random},
+                                     threads));
+    return 0;
+}
@@ -0,0 +1,299 @@
+#ifndef DUALIZATION_COVERAGE_FILE_H
+#define DUALIZATION_COVERAGE_FILE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include "dualization.h"
+
+using namespace std;
+
+/**
+ * Binary file of coverages. The file starts with a header:
+ *
+ *     char     magic[8]     "DUALCOV1"
+ *     uint32_t mode         engine that produced the file (CoverageMode)
+ *     uint32_t encoding     CoverageEncoding of the records
+ *     uint32_t arity        1 for coverages, 2 for pairs of coverages
+ *     uint32_t reserved
+ *     uint64_t height1, width1, height2, width2   shapes of the matrices
+ *     uint64_t count        number of records, 0 if the writer was not closed
+ *
+ * followed by the records. A record holds arity coverages, either as
+ * (width + 63) / 64 words of a bit set each or as a list of columns: the
+ * number of columns and the gaps between consecutive columns, all as LEB128
+ * varints. All numbers are little-endian.
+ */
+enum CoverageMode : uint32_t {
+    COVERAGES_DUALIZATION = 0,
+    COVERAGES_D1 = 1,
+    COVERAGES_D2 = 2,
+    COVERAGES_COMBINE = 3,
+    COVERAGES_COMBINE_EXIST = 4,
+};
+
+enum CoverageEncoding : uint32_t {
+    PACKED_BITSETS = 0,
+    DELTA_LISTS = 1,
+};
+
+struct CoverageFileHeader {
+    char magic[8];
+    uint32_t mode;
+    uint32_t encoding;
+    uint32_t arity;
+    uint32_t reserved;
+    uint64_t height1;
+    uint64_t width1;
+    uint64_t height2;
+    uint64_t width2;
+    uint64_t count;
+};
+
+const char COVERAGE_FILE_MAGIC[8] = {'D', 'U', 'A', 'L', 'C', 'O', 'V', '1'};
+
+/**
+ * Visitor that writes coverages to a binary coverage file through a large
+ * buffer, so that every write system call carries megabytes of records.
+ */
+class CoverageWriter : public CoverageVisitor {
+    FILE *out;
+    CoverageFileHeader header;
+    vector<unsigned char> buffer;
+    size_t used;
+    vector<ull> first_words;
+    vector<ull> second_words;
+
+    void flush() {
+        if (used && fwrite(buffer.data(), 1, used, out) != used) {
+            cerr << "Error: " << strerror(errno) << endl;
+            throw runtime_error("Failed to write coverage file");
+        }
+        used = 0;
+    }
+
+    void put(const void *data, size_t size) {
+        if (used + size > buffer.size()) flush();
+        if (size > buffer.size()) {
+            if (fwrite(data, 1, size, out) != size) {
+                cerr << "Error: " << strerror(errno) << endl;
+                throw runtime_error("Failed to write coverage file");
+            }
+            return;
+        }
+        memcpy(buffer.data() + used, data, size);
+        used += size;
+    }
+
+    void put_varint(uint64_t value) {
+        unsigned char bytes[10];
+        size_t n = 0;
+        do {
+            bytes[n] = (unsigned char) (value & 0x7F);
+            value >>= 7;
+            if (value) bytes[n] |= 0x80;
+            n++;
+        } while (value);
+        put(bytes, n);
+    }
+
+    void put_coverage(const BitsetView &coverage, size_t width) {
+        size_t chunks = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        if (coverage.getChunks() != chunks) {
+            cerr << "Coverage of size " << coverage.size()
+                 << " does not match width " << width << endl;
+            throw length_error("");
+        }
+        if (header.encoding == PACKED_BITSETS) {
+            put(coverage.words(), chunks * sizeof(ull));
+            return;
+        }
+        size_t count = 0;
+        for (size_t w = 0; w < chunks; w++)
+            count += __builtin_popcountll(coverage.words()[w]);
+        put_varint(count);
+        size_t next = 0;
+        for (size_t col: coverage) {
+            put_varint(col - next);
+            next = col + 1;
+        }
+    }
+
+public:
+    /**
+     * Creates the file and writes its header. Pairs of coverages are expected
+     * if height2 or width2 is not zero.
+     */
+    CoverageWriter(const string &filename, CoverageMode mode,
+                   CoverageEncoding encoding, size_t height1, size_t width1,
+                   size_t height2 = 0, size_t width2 = 0,
+                   size_t buffer_size = 1 << 22) : buffer(buffer_size),
+                                                   used(0) {
+        out = fopen(filename.c_str(), "wb");
+        if (out == nullptr) {
+            cerr << "Error: " << strerror(errno) << endl;
+            cerr << "Failed to open output file" << endl;
+            throw bad_exception();
+        }
+        setvbuf(out, nullptr, _IONBF, 0);
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, COVERAGE_FILE_MAGIC, sizeof(header.magic));
+        header.mode = mode;
+        header.encoding = encoding;
+        header.arity = (height2 || width2) ? 2 : 1;
+        header.height1 = height1;
+        header.width1 = width1;
+        header.height2 = height2;
+        header.width2 = width2;
+        put(&header, sizeof(header));
+    }
+
+    ~CoverageWriter() override {
+        if (out == nullptr) return;
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    void visit(const BitsetView &coverage) override {
+        put_coverage(coverage, header.width1);
+        header.count++;
+    }
+
+    void visit(const BitsetView &first, const BitsetView &second) override {
+        put_coverage(first, header.width1);
+        put_coverage(second, header.width2);
+        header.count++;
+    }
+
+    /*! Writes a pair of coverages given as sets of columns*/
+    void write(const set<size_t> &first, const set<size_t> &second) {
+        first_words.assign((header.width1 + CHUNK_SIZE - 1) / CHUNK_SIZE, 0);
+        second_words.assign((header.width2 + CHUNK_SIZE - 1) / CHUNK_SIZE, 0);
+        for (size_t col: first)
+            first_words[col / CHUNK_SIZE] |= 1ULL << (col % CHUNK_SIZE);
+        for (size_t col: second)
+            second_words[col / CHUNK_SIZE] |= 1ULL << (col % CHUNK_SIZE);
+        visit(BitsetView(first_words.data(), header.width1),
+              BitsetView(second_words.data(), header.width2));
+    }
+
+    size_t getCount() const {
+        return header.count;
+    }
+
+    /**
+     * Flushes the buffer, stores the number of records and closes the file.
+     * The file is closed even if writing fails.
+     */
+    void close() {
+        if (out == nullptr) return;
+        FILE *file = out;
+        try {
+            flush();
+        } catch (...) {
+            fclose(file);
+            out = nullptr;
+            throw;
+        }
+        bool ok = fseek(file, 0, SEEK_SET) == 0 &&
+                  fwrite(&header, sizeof(header), 1, file) == 1;
+        out = nullptr;
+        if (fclose(file) != 0 || !ok) {
+            cerr << "Error: " << strerror(errno) << endl;
+            throw runtime_error("Failed to write coverage file");
+        }
+    }
+};
+
+/**
+ * Reads a binary coverage file record by record.
+ */
+class CoverageReader {
+    FILE *in;
+    CoverageFileHeader header;
+    vector<ull> words;
+
+    bool get_varint(uint64_t &value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            int byte = fgetc(in);
+            if (byte == EOF) return false;
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        throw runtime_error("Malformed varint in coverage file");
+    }
+
+    bool get_coverage(vector<size_t> &coverage, size_t width) {
+        coverage.clear();
+        if (header.encoding == PACKED_BITSETS) {
+            size_t chunks = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            words.resize(chunks);
+            if (fread(words.data(), sizeof(ull), chunks, in) != chunks)
+                return false;
+            for (size_t col: BitsetView(words.data(), width))
+                coverage.push_back(col);
+            return true;
+        }
+        uint64_t count, gap;
+        if (!get_varint(count)) return false;
+        size_t next = 0;
+        for (uint64_t k = 0; k < count; k++) {
+            if (!get_varint(gap)) throw runtime_error("Truncated coverage file");
+            coverage.push_back(next + gap);
+            next += gap + 1;
+        }
+        return true;
+    }
+
+public:
+    explicit CoverageReader(const string &filename) {
+        in = fopen(filename.c_str(), "rb");
+        if (in == nullptr) {
+            cerr << "Error: " << strerror(errno) << endl;
+            cerr << "Failed to open input file" << endl;
+            throw bad_exception();
+        }
+        setvbuf(in, nullptr, _IOFBF, 1 << 22);
+        if (fread(&header, sizeof(header), 1, in) != 1 ||
+            memcmp(header.magic, COVERAGE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+            fclose(in);
+            throw runtime_error("Not a coverage file: " + filename);
+        }
+    }
+
+    ~CoverageReader() {
+        fclose(in);
+    }
+
+    const CoverageFileHeader &getHeader() const {
+        return header;
+    }
+
+    /**
+     * Reads the next record. second is left empty for files of single
+     * coverages. Returns false at the end of the file.
+     */
+    bool next(vector<size_t> &first, vector<size_t> &second) {
+        second.clear();
+        if (!get_coverage(first, header.width1)) return false;
+        if (header.arity == 2 && !get_coverage(second, header.width2))
+            throw runtime_error("Truncated coverage file");
+        return true;
+    }
+};
+
+/*! Writes the found pairs of coverages to a binary coverage file*/
+inline void print_results(set<pair<set<size_t>, set<size_t>>> &found_coverages,
+                          CoverageWriter &writer) {
+    for (auto &cov_pair: found_coverages) {
+        writer.write(cov_pair.first, cov_pair.second);
+    }
+}
+
+#endif //DUALIZATION_COVERAGE_FILE_H
@@ -0,0 +1,36 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "coverage_file.h"
+
+using namespace std;
+
+/**
+ * Converts a binary coverage file back to the text form printed by the
+ * engines: one {a b} or {a b}  {c d} line per record.
+ */
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " <coverage file>" << endl;
+        return 1;
+    }
+    CoverageReader reader(argv[1]);
+    vector<size_t> first, second;
+    while (reader.next(first, second)) {
+        printf("{");
+        for (auto entry: first) {
+            printf("%ld ", entry);
+        }
+        printf("}");
+        if (reader.getHeader().arity == 2) {
+            printf("  {");
+            for (auto entry: second) {
+                printf("%ld ", entry);
+            }
+            printf("}");
+        }
+        printf("\n");
+    }
+    return 0;
+}
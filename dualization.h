@@ -3,752 +3,4380 @@
 
 #include <map>
 #include <set>
+#include <mutex>
+#include <deque>
 #include <ctime>
+#include <chrono>
+#include <atomic>
+#include <thread>
 #include <cerrno>
 #include <string>
 #include <random>
 #include <vector>
+#include <memory>
+#include <numeric>
 #include <cstring>
 #include <cstdlib>
+#include <climits>
 #include <fstream>
+#include <iomanip>
+#include <iterator>
 #include <iostream>
 #include <algorithm>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
 typedef uint64_t ull;
-size_t cov_count = 0;
+#ifdef __SIZEOF_INT128__
+/*! Number of coverages, wide enough not to overflow on large instances*/
+typedef unsigned __int128 count_t;
+#else
+typedef uint64_t count_t;
+#endif
 
 enum {
-    CHUNK_SIZE = sizeof(ull),
+    CHUNK_SIZE = 8 * sizeof(ull),
+    CACHE_LINE = 64,
 };
-bool MODE = true; //set MODE=true if the existence of second coverage is in question
 
-class customset {
-    ull *data;
-public:
-    size_t sz;
-    size_t chunks;
+inline string count_to_string(count_t count) {
+    string digits;
+    do {
+        digits += char('0' + int(count % 10));
+        count /= 10;
+    } while (count);
+    return string(digits.rbegin(), digits.rend());
+}
 
-    explicit customset(size_t size) : sz(size) {
-        chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
-        data = (ull *) calloc(chunks, sizeof(ull));
+/**
+ * Checks that every bit set in a is also set in b. Both arrays have the given
+ * number of words.
+ */
+inline bool is_subset(const ull *a, const ull *b, size_t chunks) {
+    size_t w = 0;
+#if defined(__AVX512F__)
+    for (; w + 8 <= chunks; w += 8) {
+        __m512i va = _mm512_loadu_si512((const void *) (a + w));
+        __m512i vb = _mm512_loadu_si512((const void *) (b + w));
+        if (_mm512_test_epi64_mask(va, _mm512_andnot_si512(vb, va))) return false;
     }
-
-    customset(set<size_t> source, size_t size) : sz(size) {
-        chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
-        data = (ull *) calloc(chunks, sizeof(ull));
-        for (auto entry: source) {
-            this->sett(entry);
-        }
+#endif
+#if defined(__AVX2__)
+    for (; w + 4 <= chunks; w += 4) {
+        __m256i va = _mm256_loadu_si256((const __m256i *) (a + w));
+        __m256i vb = _mm256_loadu_si256((const __m256i *) (b + w));
+        if (!_mm256_testc_si256(vb, va)) return false;
     }
-
-    customset(const customset &source) : sz(source.sz), chunks(source.chunks) {
-        data = source.data;
+#endif
+    for (; w < chunks; w++) {
+        if (a[w] & ~b[w]) return false;
     }
+    return true;
+}
 
-    customset &operator=(const customset &source) {
-        data = source.data;
-        sz = source.sz;
-        return *this;
+/**
+ * Checks that a and b have no common bits. Both arrays have the given number
+ * of words.
+ */
+inline bool is_disjoint(const ull *a, const ull *b, size_t chunks) {
+    size_t w = 0;
+#if defined(__AVX512F__)
+    for (; w + 8 <= chunks; w += 8) {
+        __m512i va = _mm512_loadu_si512((const void *) (a + w));
+        __m512i vb = _mm512_loadu_si512((const void *) (b + w));
+        if (_mm512_test_epi64_mask(va, vb)) return false;
     }
-
-//    ~customset() {
-//        if (!used)
-//            free(data);
-//    }
-    bool operator<(const customset &b) const {
-        for (int i = 0; i < chunks; i++) {
-            if (data[i] != b.data[i]) return (data[i] < b.data[i]);
-        }
-        return false;
+#endif
+#if defined(__AVX2__)
+    for (; w + 4 <= chunks; w += 4) {
+        __m256i va = _mm256_loadu_si256((const __m256i *) (a + w));
+        __m256i vb = _mm256_loadu_si256((const __m256i *) (b + w));
+        if (!_mm256_testz_si256(va, vb)) return false;
     }
-
-    void sett(ull k) {
-        data[k / CHUNK_SIZE] |= ((ull) 1) << (k % CHUNK_SIZE);
+#endif
+    for (; w < chunks; w++) {
+        if (a[w] & b[w]) return false;
     }
+    return true;
+}
 
-    void clear(ull k) {
-        data[k / CHUNK_SIZE] &= ~((ull) 1 << (k % CHUNK_SIZE));
-    }
+/*! Word count of a fixed-width kernel: WORDS, or chunks if WORDS is 0*/
+template<size_t WORDS>
+inline size_t fixed_words(size_t chunks) {
+    return WORDS ? WORDS : chunks;
+}
 
-    bool in(ull k) const {
-        return bool((ull) 1 & (data[k / CHUNK_SIZE] >> (k % CHUNK_SIZE)));
-    }
+/**
+ * is_subset for arrays of WORDS words, which the compiler unrolls into a few
+ * register operations. WORDS = 0 is the generic kernel.
+ */
+template<size_t WORDS>
+inline bool is_subset(const ull *a, const ull *b, size_t chunks) {
+    if (WORDS == 0) return is_subset(a, b, chunks);
+    ull extra = 0;
+    for (size_t w = 0; w < WORDS; w++) extra |= a[w] & ~b[w];
+    return extra == 0;
+}
 
-    friend bool check_intersection(customset s1, customset s2);
-};
+template<size_t WORDS>
+inline bool is_disjoint(const ull *a, const ull *b, size_t chunks) {
+    if (WORDS == 0) return is_disjoint(a, b, chunks);
+    ull common = 0;
+    for (size_t w = 0; w < WORDS; w++) common |= a[w] & b[w];
+    return common == 0;
+}
 
-bool check_intersection(customset s1, customset s2) {
-    if (s1.sz != s2.sz) {
-        cerr << "Sets should be of equal size" << endl;
-    }
-    size_t chunks = (s1.sz + CHUNK_SIZE - 1) / CHUNK_SIZE;
-    for (int i = 0; i < chunks; i++) {
-        if (s1.data[i] & s2.data[i]) return false;
-    }
-    return true;
+template<size_t WORDS>
+inline bool same_words(const ull *a, const ull *b, size_t chunks) {
+    if (WORDS == 0) return memcmp(a, b, chunks * sizeof(ull)) == 0;
+    ull diff = 0;
+    for (size_t w = 0; w < WORDS; w++) diff |= a[w] ^ b[w];
+    return diff == 0;
 }
 
-set<customset> default_coverage;
-set<pair<set<size_t>, set<size_t>>> default_found_coverages;
+template<size_t WORDS>
+using Words = integral_constant<size_t, WORDS>;
 
 /**
- * A simple class for binary matrix stored as bit sets
+ * Calls f with Words<chunks> if there are fixed-width kernels for that many
+ * words (1, 2 and 4, i.e. up to 64, 128 and 256 bits) and with Words<0>, the
+ * generic kernels, otherwise.
  */
-class BitMatrix {
-    /*! The matrix where all data is stored*/
-    vector<vector<ull>> matrix;
-    size_t height;
-    size_t width;
-    size_t chunks;
+template<class F>
+inline auto dispatch_words(size_t chunks, F f) -> decltype(f(Words<0>())) {
+    switch (chunks) {
+        case 1:
+            return f(Words<1>());
+        case 2:
+            return f(Words<2>());
+        case 4:
+            return f(Words<4>());
+        default:
+            return f(Words<0>());
+    }
+}
+
+/**
+ * Read-only view of a bit set stored in an array of words. Iterating over it
+ * yields the indices of the set bits in increasing order.
+ */
+class BitsetView {
+    const ull *data;
+    size_t sz;
 
 public:
-    BitMatrix() : height(0), width(0), chunks(0) {}
+    class iterator {
+        const ull *data;
+        size_t sz;
+        size_t pos;
 
-    BitMatrix(istream &in, size_t n, size_t m) : height(n), width(m) {
-        ull bit;
-        chunks = width / CHUNK_SIZE + 1 - (width % CHUNK_SIZE == 0);
-
-        for (int i = 0; i < height; i++) {
-            vector<ull> row;
-            row.clear();
-            for (int j = 0; j < chunks; j++) {
-                ull chunk = 0;
-                for (int k = 1;
-                     (k <= CHUNK_SIZE) && (j * CHUNK_SIZE + k <= width); k++) {
-                    if (!(in >> bit)) {
-                        cerr << "Incorrect size of input matrix" << endl;
-                        throw length_error("");
-                    }
-                    if (bit > 1) {
-                        cerr << "Incorrect value encountered in input stream: "
-                             << bit << endl;
-                        throw out_of_range("");
-                    }
-                    chunk |= (bit << (CHUNK_SIZE - k));
+        void seek(size_t from) {
+            size_t chunks = (sz + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            size_t w = from / CHUNK_SIZE;
+            if (w >= chunks) {
+                pos = sz;
+                return;
+            }
+            ull word = data[w] & (~0ULL << (from % CHUNK_SIZE));
+            while (word == 0) {
+                if (++w >= chunks) {
+                    pos = sz;
+                    return;
                 }
-                row.push_back(chunk);
+                word = data[w];
             }
-            matrix.push_back(row);
+            pos = w * CHUNK_SIZE + __builtin_ctzll(word);
         }
-    }
 
-    BitMatrix(const string &filename, size_t n, size_t m) : height(n),
-                                                            width(m) {
-        ifstream in;
-        in.open(filename);
-        if (!in.is_open()) {
-            cerr << "Error: " << strerror(errno) << endl;
-            cerr << "Failed to open input file" << endl;
-            throw bad_exception();
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef size_t value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const size_t *pointer;
+        typedef size_t reference;
+
+        iterator(const ull *data, size_t sz, size_t from) : data(data), sz(sz) {
+            seek(from);
         }
-        ull bit;
-        chunks = width / CHUNK_SIZE + 1 - (width % CHUNK_SIZE == 0);
-
-        for (int i = 0; i < height; i++) {
-            vector<ull> row;
-            row.clear();
-            for (int j = 0; j < chunks; j++) {
-                ull chunk = 0;
-                for (size_t k = 1;
-                     (k <= CHUNK_SIZE) && (j * CHUNK_SIZE + k <= width); k++) {
-                    if (!(in >> bit)) {
-                        cerr << "Incorrect size of input matrix" << endl;
-                        throw length_error("");
-                    }
-                    if (bit > 1) {
-                        cerr << "Incorrect value encountered in input stream: "
-                             << bit << endl;
-                        throw out_of_range("");
-                    }
-                    chunk |= (bit << (CHUNK_SIZE - k));
-                }
-                row.push_back(chunk);
-            }
-            matrix.push_back(row);
+
+        size_t operator*() const {
+            return pos;
+        }
+
+        iterator &operator++() {
+            seek(pos + 1);
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const {
+            return pos == other.pos;
+        }
+
+        bool operator!=(const iterator &other) const {
+            return pos != other.pos;
         }
-        in.close();
+    };
+
+    BitsetView() : data(nullptr), sz(0) {}
+
+    BitsetView(const ull *data, size_t size) : data(data), sz(size) {}
+
+    iterator begin() const {
+        return iterator(data, sz, 0);
     }
 
-    ~BitMatrix() {
-        for (auto a: matrix) a.clear();
-        matrix.clear();
+    iterator end() const {
+        return iterator(data, sz, sz);
     }
 
-    size_t getHeight() const {
-        return height;
+    bool in(size_t k) const {
+        return bool((data[k / CHUNK_SIZE] >> (k % CHUNK_SIZE)) & 1ULL);
     }
 
-    size_t getWidth() const {
-        return width;
+    size_t size() const {
+        return sz;
     }
 
-    size_t getChunks() const {
-        return chunks;
+    /*! Number of elements of the set*/
+    size_t count() const {
+        size_t total = 0;
+        for (size_t w = 0; w < getChunks(); w++) total += __builtin_popcountll(data[w]);
+        return total;
     }
 
-    const vector<vector<ull>> &getMatrix() const {
-        return matrix;
+    size_t getChunks() const {
+        return (sz + CHUNK_SIZE - 1) / CHUNK_SIZE;
     }
 
-    int at(size_t i, size_t j) const {
-        size_t shift = CHUNK_SIZE - 1 - j % CHUNK_SIZE;
-        return int((matrix[i][j / CHUNK_SIZE] & (1ULL << shift)) >> shift);
+    const ull *words() const {
+        return data;
     }
 
-    friend ostream &operator<<(ostream &os, const BitMatrix &bm);
+    set<size_t> to_set() const {
+        return set<size_t>(begin(), end());
+    }
 };
 
-ostream &operator<<(ostream &os, const BitMatrix &bm) {
-    cout << "Bit matrix with shape (" << bm.height << ", " << bm.width << ")"
-         << endl << endl;
-    for (size_t i = 0; i < bm.height; i++) {
-        for (size_t j = 0; j < bm.width; j++) {
-            cout << bm.at(i, j) << ' ';
-        }
-        cout << endl;
-    }
-    cout << endl;
-    return os;
+/**
+ * Allocates a zero-filled buffer of words aligned to a cache line. The buffer
+ * is released when the last owner goes away.
+ */
+inline shared_ptr<ull> allocate_words(size_t count) {
+    size_t bytes = (count * sizeof(ull) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    if (bytes == 0) bytes = CACHE_LINE;
+    void *ptr = aligned_alloc(CACHE_LINE, bytes);
+    if (ptr == nullptr) throw bad_alloc();
+    memset(ptr, 0, bytes);
+    return shared_ptr<ull>((ull *) ptr, free);
 }
 
-class PartialBitMatrix : public BitMatrix {
-    set<size_t> available_rows;
-    set<size_t> available_cols;
-    set<size_t> selected_cols;
-    size_t cur_height;
-    size_t cur_width;
+/**
+ * Coverages of one width stored one after another in slabs of words, so a
+ * coverage takes (width + 63) / 64 words and inserting is amortized O(1).
+ * Equal coverages are stored once unless deduplication is turned off for
+ * producers that never repeat a coverage. Coverages keep their addresses
+ * until clear(), which releases all slabs at once.
+ */
+class CoverageStore {
+    enum : size_t {
+        SLAB_WORDS = 1 << 16,
+        EMPTY = SIZE_MAX,
+    };
 
-    void delete_zero_columns() {
-        vector<ull> rows_disjunction;
+    vector<shared_ptr<ull>> slabs;
+    /*! Numbers of the coverages by hash, EMPTY in free slots*/
+    vector<size_t> table;
+    size_t width, chunks, count;
+    /*! A slab holds 2^slab_shift coverages*/
+    size_t slab_shift;
+    bool dedupe;
 
-        for (size_t j = 0; j < this->getChunks(); j++)
-            rows_disjunction.push_back(0);
+    ull *slot(size_t k) const {
+        return slabs[k >> slab_shift].get() +
+               (k & ((size_t(1) << slab_shift) - 1)) * chunks;
+    }
 
-        for (size_t i: available_rows) {
-            for (size_t j = 0; j < this->getChunks(); j++) {
-                rows_disjunction[j] |= this->getMatrix()[i][j];
-            }
-        }
-        size_t shift;
-        for (size_t j: available_cols) {
-            shift = CHUNK_SIZE - 1 - j % CHUNK_SIZE;
-            if ((rows_disjunction[j / CHUNK_SIZE] & (1ULL << shift)) >> shift ==
-                0) {
-                //cout << "Deleted zero column: " << j << endl;
-                delete_column(j, false);
-            }
+    template<size_t C>
+    size_t hash(const ull *words) const {
+        ull h = 0x9E3779B97F4A7C15ULL ^ width;
+        for (size_t w = 0; w < fixed_words<C>(chunks); w++) {
+            h = (h ^ words[w]) * 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 32;
         }
+        return h;
     }
 
-    void delete_wider_rows() {
-        bool fl; //fl is true if line1 >= line2
-        size_t shift;
-        set<size_t> wider_rows;
-        for (size_t i: available_rows) {
-            for (size_t j: available_rows) {
-                if (i == j) continue;
-                fl = true;
-                for (size_t k: available_cols) {
-                    shift = CHUNK_SIZE - 1 - k % CHUNK_SIZE;
-                    if ((this->getMatrix()[i][k / CHUNK_SIZE] & (1ULL << shift))
-                        < (this->getMatrix()[j][k / CHUNK_SIZE] &
-                           (1ULL << shift))) {
-                        fl = false;
-                        break;
-                    }
-                }
-                if (fl) {
-                    //cout << "Deleted wider row: " << i << endl;
-                    delete_row(i, false);
-                }
-            }
+    template<size_t C>
+    size_t find(const ull *words) const {
+        size_t mask = table.size() - 1;
+        for (size_t i = hash<C>(words) & mask;; i = (i + 1) & mask) {
+            if (table[i] == EMPTY || same_words<C>(slot(table[i]), words, chunks))
+                return i;
         }
     }
 
-public:
-    PartialBitMatrix(istream &in, size_t n, size_t m) : BitMatrix(in, n, m) {
-        for (size_t i = 0; i < n; i++) available_rows.insert(i);
-        for (size_t i = 0; i < m; i++) available_cols.insert(i);
-        cur_height = this->getHeight();
-        cur_width = this->getWidth();
-
-        update_matrix();
+    /*! Slot of the table holding words, or the free slot where it belongs*/
+    size_t find(const ull *words) const {
+        return dispatch_words(chunks, [&](auto C) {
+            return find<decltype(C)::value>(words);
+        });
     }
 
-    PartialBitMatrix(const string &filename, size_t n, size_t m) : BitMatrix(
-            filename, n, m) {
-        for (size_t i = 0; i < n; i++) available_rows.insert(i);
-        for (size_t i = 0; i < m; i++) available_cols.insert(i);
-        cur_height = this->getHeight();
-        cur_width = this->getWidth();
+    void rehash(size_t size) {
+        table.assign(size, EMPTY);
+        for (size_t k = 0; k < count; k++) table[find(slot(k))] = k;
+    }
 
-        update_matrix();
+    void set_width(size_t size) {
+        width = size;
+        chunks = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        slab_shift = 0;
+        while ((size_t(2) << slab_shift) * max<size_t>(chunks, 1) <= SLAB_WORDS)
+            slab_shift++;
     }
 
-    PartialBitMatrix() : cur_width(0), cur_height(0) {}
+public:
+    explicit CoverageStore(bool dedupe = true) : width(0), chunks(0), count(0),
+                                                  slab_shift(0), dedupe(dedupe) {}
 
-    void delete_column(size_t col, bool outside = true) {
-        if (col >= this->getWidth()) {
-            cerr << "Invalid column number" << endl;
-            throw out_of_range("");
+    CoverageStore(const CoverageStore &) = delete;
+
+    CoverageStore &operator=(const CoverageStore &) = delete;
+
+    CoverageStore(CoverageStore &&) = default;
+
+    CoverageStore &operator=(CoverageStore &&) = default;
+
+    /**
+     * Adds a copy of coverage. The width is fixed by the first coverage of the
+     * store. Returns false if the coverage is already stored.
+     */
+    bool insert(const BitsetView &coverage) {
+        if (count == 0 && slabs.empty()) set_width(coverage.size());
+        if (coverage.size() != width) {
+            cerr << "Sets should be of equal size" << endl;
+            throw length_error("");
         }
-        if (cur_width <= 0)
-            cur_height = 0;
-        else if (available_cols.find(col) != available_cols.end()) cur_width--;
+        size_t pos = 0;
+        if (dedupe) {
+            if (2 * (count + 1) > table.size()) rehash(max<size_t>(16, 2 * table.size()));
+            pos = find(coverage.words());
+            if (table[pos] != EMPTY) return false;
+        }
+        if ((count >> slab_shift) == slabs.size())
+            slabs.push_back(allocate_words(chunks << slab_shift));
+        memcpy(slot(count), coverage.words(), chunks * sizeof(ull));
+        if (dedupe) table[pos] = count;
+        count++;
+        return true;
+    }
 
-        available_cols.erase(col);
-        if (outside) selected_cols.insert(col);
+    bool contains(const BitsetView &coverage) const {
+        if (count == 0 || coverage.size() != width) return false;
+        if (dedupe) return table[find(coverage.words())] != EMPTY;
+        for (size_t k = 0; k < count; k++)
+            if (memcmp(slot(k), coverage.words(), chunks * sizeof(ull)) == 0)
+                return true;
+        return false;
     }
 
-/**
- * @param row
- * @return
- */
-    void delete_row(size_t row, bool outside = true) {
-        if (row >= this->getHeight()) {
-            cerr << "Invalid row number" << endl;
-            throw out_of_range("");
+    /*! Adds the coverages of another store*/
+    void merge(const CoverageStore &other) {
+        for (size_t k = 0; k < other.size(); k++) insert(other[k]);
+    }
+
+    /**
+     * Orders the coverages by their words, lowest word first, which is the
+     * order the coverages used to have in a set<customset>.
+     */
+    void sort() {
+        vector<size_t> order(count);
+        for (size_t k = 0; k < count; k++) order[k] = k;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            const ull *x = slot(a), *y = slot(b);
+            for (size_t w = 0; w < chunks; w++)
+                if (x[w] != y[w]) return x[w] < y[w];
+            return false;
+        });
+        vector<shared_ptr<ull>> source;
+        source.swap(slabs);
+        count = 0;
+        for (size_t k: order) {
+            const ull *words = source[k >> slab_shift].get() +
+                               (k & ((size_t(1) << slab_shift) - 1)) * chunks;
+            if ((count >> slab_shift) == slabs.size())
+                slabs.push_back(allocate_words(chunks << slab_shift));
+            memcpy(slot(count), words, chunks * sizeof(ull));
+            count++;
         }
-        if (cur_height <= 0)
-            cur_height = 0;
-        else if (available_rows.find(row) != available_rows.end()) cur_height--;
+        if (dedupe) rehash(table.size());
+    }
 
-        available_rows.erase(row);
+    /*! Releases all coverages. The next coverage may have another width*/
+    void clear() {
+        slabs.clear();
+        table.clear();
+        count = 0;
     }
 
-    void update_matrix() {
-        delete_zero_columns();
-        delete_wider_rows();
+    size_t size() const {
+        return count;
     }
 
-    size_t getCur_height() const {
-        return cur_height;
+    bool empty() const {
+        return count == 0;
     }
 
-    size_t getCur_width() const {
-        return cur_width;
+    size_t getWidth() const {
+        return width;
     }
 
-    const set<size_t> &getAvailable_rows() const {
-        return available_rows;
+    size_t getChunks() const {
+        return chunks;
     }
 
-    const set<size_t> &getAvailable_cols() const {
-        return available_cols;
+    const ull *at(size_t k) const {
+        return slot(k);
     }
 
-    const set<size_t> &getSelected_cols() const {
-        return selected_cols;
+    BitsetView operator[](size_t k) const {
+        return BitsetView(slot(k), width);
     }
 
-    pair<size_t, size_t> getLightestRow() const {
-        ull tmp;
-        size_t count, min = getHeight() + 1, min_n = 0;
-        for (auto row: available_rows) {
-            count = 0;
-            for (int i = 0; i < getChunks(); i++) {
-                tmp = getMatrix()[row][i];
-                while (tmp != 0) {
-                    tmp = tmp & (tmp - 1);
-                    count++;
-                }
-            }
-            if (count < min) {
-                min = count;
-                min_n = row;
-            }
+    class iterator {
+        const CoverageStore *store;
+        size_t k;
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef BitsetView value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const BitsetView *pointer;
+        typedef BitsetView reference;
+
+        iterator(const CoverageStore *store, size_t k) : store(store), k(k) {}
+
+        BitsetView operator*() const {
+            return (*store)[k];
         }
-        return {min_n, min};
+
+        iterator &operator++() {
+            k++;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator old = *this;
+            k++;
+            return old;
+        }
+
+        bool operator==(const iterator &other) const {
+            return k == other.k;
+        }
+
+        bool operator!=(const iterator &other) const {
+            return k != other.k;
+        }
+    };
+
+    iterator begin() const {
+        return iterator(this, 0);
     }
 
-    friend ostream &operator<<(ostream &os, const PartialBitMatrix &bm);
+    iterator end() const {
+        return iterator(this, count);
+    }
 };
 
-ostream &operator<<(ostream &os, const PartialBitMatrix &bm) {
-    cout << "Partial bit matrix with initial shape (" << bm.getHeight() << ", "
-         << bm.getWidth() << ")" << endl;
-    cout << "Current shape (" << bm.cur_height << ", " << bm.cur_width << ")"
-         << endl << endl;
-    for (auto i: bm.available_rows) {
-        for (auto j: bm.available_cols) {
-            cout << bm.at(i, j) << ' ';
+/**
+ * Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+    void *address;
+    size_t length;
+
+public:
+    explicit MappedFile(const string &filename) : address(nullptr), length(0) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            cerr << "Error: " << strerror(errno) << endl;
+            cerr << "Failed to open input file" << endl;
+            if (fd >= 0) close(fd);
+            throw bad_exception();
         }
-        cout << endl;
+        length = info.st_size;
+        if (length) {
+            address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address == MAP_FAILED) {
+                cerr << "Error: " << strerror(errno) << endl;
+                close(fd);
+                throw bad_exception();
+            }
+            madvise(address, length, MADV_SEQUENTIAL);
+        }
+        close(fd);
     }
-    cout << "Available cols: [";
-    for (auto entry: bm.getAvailable_cols()) cout << entry << ",";
-    cout << ']' << endl;
-    cout << "Available rows: [";
-    for (auto entry: bm.getAvailable_rows()) cout << entry << ",";
-    cout << ']' << endl;
-    cout << "Selected cols: [";
-    for (auto entry: bm.getSelected_cols()) cout << entry << ",";
-    cout << ']' << endl;
-    cout << endl;
-    return os;
-}
 
-bool check_support_rows(PartialBitMatrix &L,
-                        map<size_t, set<size_t>> &supporting_rows, size_t col) {
-    set<size_t> one_rows;
-    for (size_t i = 0; i < L.getHeight(); i++) {
-        if (L.at(i, col)) one_rows.insert(i);
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+        if (length) munmap(address, length);
     }
-    for (auto &entry: supporting_rows) {
-        if (includes(one_rows.begin(), one_rows.end(), entry.second.begin(),
-                     entry.second.end()))
-            return false;
+
+    const char *data() const {
+        return (const char *) address;
     }
-    return true;
-}
 
-map<size_t, set<size_t>> update_support_rows(PartialBitMatrix &L,
-                                             map<size_t, set<size_t>> &supporting_rows,
-                                             size_t col) {
-    set<size_t> one_rows;
-    for (size_t i = 0; i < L.getHeight(); i++) {
-        if (L.at(i, col)) one_rows.insert(i);
+    size_t size() const {
+        return length;
+    }
+};
+
+/**
+ * Header of a binary matrix file. It is followed by height * stride words of
+ * rows and width * column_stride words of columns, in the layout BitMatrix
+ * keeps in memory. The header is one cache line long, so a mapped file keeps
+ * the rows aligned.
+ */
+struct MatrixFileHeader {
+    char magic[8];
+    uint64_t height;
+    uint64_t width;
+    uint64_t stride;
+    uint64_t column_stride;
+    uint64_t reserved[3];
+};
+
+const char MATRIX_FILE_MAGIC[8] = {'D', 'U', 'A', 'L', 'M', 'A', 'T', '1'};
+
+/**
+ * A simple class for binary matrix stored as bit sets.
+ *
+ * All rows live in one contiguous cache-line aligned buffer, row i starts at
+ * word i * stride and bit j of a row is bit j % 64 of word j / 64. A second
+ * buffer holds the transposed matrix in the same layout, so that the rows
+ * having 1 in a column are available as a bit set too. The data is never
+ * modified after loading, so copies share the same buffers.
+ */
+class BitMatrix {
+    /*! The buffer where all data is stored*/
+    shared_ptr<ull> storage;
+    /*! Column-major copy of storage*/
+    shared_ptr<ull> transposed;
+    size_t height;
+    size_t width;
+    size_t chunks;
+    size_t stride;
+    size_t column_chunks;
+
+    void allocate() {
+        chunks = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        stride = chunks;
+        column_chunks = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        storage = allocate_words(height * stride);
+        transposed = allocate_words(width * column_chunks);
     }
-    map<size_t, set<size_t>> copy = supporting_rows;
-    for (auto &entry: copy) {
-        for (auto row: entry.second) {
-            if (one_rows.find(row) != one_rows.end()) {
-                entry.second.erase(row);
-                one_rows.erase(row);
+
+    /*! Fills the column-major copy from the rows*/
+    void transpose() {
+        for (size_t i = 0; i < height; i++) {
+            const ull *words = row(i);
+            for (size_t c = 0; c < chunks; c++) {
+                ull bits = words[c];
+                while (bits) {
+                    size_t j = c * CHUNK_SIZE + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    transposed.get()[j * column_chunks + i / CHUNK_SIZE] |=
+                            1ULL << (i % CHUNK_SIZE);
+                }
             }
         }
     }
-    copy[col] = one_rows;
-    return copy;
-}
 
-void D1_dualization(PartialBitMatrix &L1, PartialBitMatrix &L2, \
-    map<size_t, set<size_t>> &supporting_rows1,
-                    map<size_t, set<size_t>> &supporting_rows2,
-                    bool weights = false, \
-    bool save = false,
-                    set<pair<set<size_t>, set<size_t>>> &found_coverages = default_found_coverages) {
-    //cout << "FIRST:" << L1 << "SECOND:" << L2 << endl << endl;
-    PartialBitMatrix L_new;
-    map<size_t, set<size_t>> supporting_rows_new;
-    bool L1_empty, L2_empty, first = false;
-    size_t row_number;
+    void read(istream &in) {
+        ull bit;
+        allocate();
 
-    L1_empty = L1.getCur_height() == 0;
-    L2_empty = L2.getCur_height() == 0;
-    if (L1_empty && L2_empty) {
-        if (save) {
-            found_coverages.insert(
-                    {L1.getSelected_cols(), L2.getSelected_cols()});
-        } else {
-            cov_count++;
-            printf("{");
-            for (auto entry: L1.getSelected_cols()) {
-                printf("%ld ", entry);
-            }
-            printf("}  {");
-            for (auto entry: L2.getSelected_cols()) {
-                printf("%ld ", entry);
+        for (size_t i = 0; i < height; i++) {
+            ull *dst = storage.get() + i * stride;
+            for (size_t j = 0; j < width; j++) {
+                if (!(in >> bit)) {
+                    cerr << "Incorrect size of input matrix" << endl;
+                    throw length_error("");
+                }
+                if (bit > 1) {
+                    cerr << "Incorrect value encountered in input stream: "
+                         << bit << endl;
+                    throw out_of_range("");
+                }
+                dst[j / CHUNK_SIZE] |= bit << (j % CHUNK_SIZE);
             }
-            printf("}\n");
         }
-        return;
+        transpose();
     }
-    if (weights) {
-        pair<size_t, size_t> res1, res2;
-        if (!L1_empty) res1 = L1.getLightestRow();
-        if (!L2_empty) res2 = L2.getLightestRow();
-        if (res1.second >= res2.second) {
-            row_number = res1.first;
-            first = true;
-        } else {
-            row_number = res2.first;
-            first = false;
+
+    /**
+     * Reads the next 0/1 token of a text matrix. Returns false at the end of
+     * the text. Sets newline if a line break was skipped before the token.
+     */
+    static bool scan(const char *&p, const char *end, ull &bit, bool &newline) {
+        newline = false;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+            if (*p == '\n') newline = true;
+            p++;
         }
-    } else {
-        if (!L1_empty) {
-            row_number = *L1.getAvailable_rows().begin();
-            first = true;
-            if (!L2_empty && (row_number > *L2.getAvailable_rows().begin())) {
-                row_number = *L2.getAvailable_rows().begin();
-                first = false;
-            }
-        } else {
-            row_number = *L2.getAvailable_rows().begin();
-        }
-    }
-    if (first) {
-        for (size_t col: L1.getAvailable_cols()) {
-            if (L1.at(row_number, col) && (L2.getSelected_cols().find(col) ==
-                                           L2.getSelected_cols().end())) {
-                if (check_support_rows(L1, supporting_rows1, col)) {
-                    supporting_rows_new = update_support_rows(L1,
-                                                              supporting_rows1,
-                                                              col);
-                    L_new = L1;
-                    for (size_t i = 0; i < L1.getHeight(); i++) {
-                        if (L1.at(i, col)) L_new.delete_row(i);
-                    }
-                    L_new.delete_column(col);
-                    L_new.update_matrix();
-                    D1_dualization(L_new, L2, supporting_rows_new,
-                                   supporting_rows2, weights, save,
-                                   found_coverages);
+        if (p == end) return false;
+        ull value = 0;
+        const char *start = p;
+        while (p < end && *p >= '0' && *p <= '9' && value <= 1) {
+            value = value * 10 + (*p - '0');
+            p++;
+        }
+        if (p == start || value > 1 || (p < end && *p > ' ')) {
+            while (p < end && *p > ' ') p++;
+            cerr << "Incorrect value encountered in input stream: "
+                 << string(start, p) << endl;
+            throw out_of_range("");
+        }
+        bit = value;
+        return true;
+    }
+
+    /*! Shape of a text matrix with one row per non-empty line*/
+    static pair<size_t, size_t> text_shape(const char *p, const char *end) {
+        size_t rows = 0, cols = 0, line = 0;
+        bool newline;
+        ull bit;
+        while (scan(p, end, bit, newline)) {
+            if (newline && line) {
+                if (rows && line != cols) {
+                    cerr << "Row " << rows << " has " << line
+                         << " values instead of " << cols << endl;
+                    throw length_error("");
                 }
+                cols = line;
+                rows++;
+                line = 0;
+            }
+            line++;
+        }
+        if (line) {
+            if (rows && line != cols) {
+                cerr << "Row " << rows << " has " << line
+                     << " values instead of " << cols << endl;
+                throw length_error("");
             }
+            cols = line;
+            rows++;
         }
+        return {rows, cols};
+    }
 
-    } else {
-        for (size_t col: L2.getAvailable_cols()) {
-            if (L2.at(row_number, col) && (L1.getSelected_cols().find(col) ==
-                                           L1.getSelected_cols().end())) {
-                if (check_support_rows(L2, supporting_rows2, col)) {
-                    supporting_rows_new = update_support_rows(L2,
-                                                              supporting_rows2,
-                                                              col);
-                    L_new = L2;
-                    for (size_t i = 0; i < L2.getHeight(); i++) {
-                        if (L2.at(i, col)) L_new.delete_row(i);
-                    }
-                    L_new.delete_column(col);
-                    L_new.update_matrix();
-                    D1_dualization(L1, L_new, supporting_rows1,
-                                   supporting_rows_new, weights, save,
-                                   found_coverages);
+    /*! Fills the matrix from the 0/1 tokens of a text, row by row*/
+    void parse(const char *p, const char *end) {
+        bool newline;
+        ull bit;
+        allocate();
+        for (size_t i = 0; i < height; i++) {
+            ull *dst = storage.get() + i * stride;
+            for (size_t j = 0; j < width; j++) {
+                if (!scan(p, end, bit, newline)) {
+                    cerr << "Incorrect size of input matrix" << endl;
+                    throw length_error("");
                 }
+                dst[j / CHUNK_SIZE] |= bit << (j % CHUNK_SIZE);
             }
         }
+        transpose();
     }
-}
-
-void D2_dualization(PartialBitMatrix &L1, PartialBitMatrix &L2, \
-    map<size_t, set<size_t>> &supporting_rows1,
-                    map<size_t, set<size_t>> &supporting_rows2,
-                    bool weights = false, \
-    bool save = false,
-                    set<pair<set<size_t>, set<size_t>>> &found_coverages = default_found_coverages) {
-
-    // cout << "FIRST:" << L1 << "SECOND:" << L2 << endl << endl;
-    PartialBitMatrix L1_new, L2_new;
-    map<size_t, set<size_t>> supporting_rows1_new, supporting_rows2_new;
-    bool L1_empty, L2_empty;
-    size_t row_number1, row_number2;
-    set<size_t> one_cols1, one_cols2;
-
-    L1_empty = L1.getCur_height() == 0;
-    L2_empty = L2.getCur_height() == 0;
 
-    if (L1_empty && L2_empty) {
-        if (save) {
-            found_coverages.insert(
-                    {L1.getSelected_cols(), L2.getSelected_cols()});
-        } else {
-            cov_count++;
-            printf("{");
-            for (auto entry: L1.getSelected_cols()) {
-                printf("%ld ", entry);
-            }
-            printf("}  {");
-            for (auto entry: L2.getSelected_cols()) {
-                printf("%ld ", entry);
+    /**
+     * Checks that the column-major copy holds exactly the bits of the rows:
+     * every 1 of a row is set in its column, and the columns have no other
+     * bits, in particular none past the height.
+     */
+    bool columns_match_rows() const {
+        size_t ones = 0;
+        for (size_t i = 0; i < height; i++) {
+            const ull *words = row(i);
+            for (size_t c = 0; c < chunks; c++) {
+                for (ull bits = words[c]; bits; bits &= bits - 1) {
+                    size_t j = c * CHUNK_SIZE + __builtin_ctzll(bits);
+                    if (!((column(j)[i / CHUNK_SIZE] >> (i % CHUNK_SIZE)) & 1ULL))
+                        return false;
+                    ones++;
+                }
             }
-            printf("}\n");
         }
+        for (size_t w = 0; w < width * column_chunks; w++)
+            ones -= __builtin_popcountll(transposed.get()[w]);
+        return ones == 0;
     }
 
-    if (weights) {
-        if (!L1_empty) {
-            row_number1 = L1.getLightestRow().first;
-            for (size_t col: L1.getAvailable_cols()) {
-                if (L1.at(row_number1, col)) one_cols1.insert(col);
-            }
+    /*! Uses the rows and columns of a binary matrix file in place*/
+    void map_binary(const shared_ptr<MappedFile> &file) {
+        MatrixFileHeader header;
+        memcpy(&header, file->data(), sizeof(header));
+        height = header.height;
+        width = header.width;
+        chunks = width / CHUNK_SIZE + (width % CHUNK_SIZE != 0);
+        column_chunks = height / CHUNK_SIZE + (height % CHUNK_SIZE != 0);
+        stride = header.stride;
+        size_t words = (file->size() - sizeof(header)) / sizeof(ull);
+        bool fits = stride >= chunks && header.column_stride >= column_chunks &&
+                    (height == 0 || stride <= words / height);
+        if (fits) words -= height * stride;
+        if (!fits || (width && header.column_stride > words / width)) {
+            cerr << "Corrupted binary matrix file" << endl;
+            throw length_error("");
         }
-        if (!L2_empty) {
-            row_number2 = L2.getLightestRow().first;
-            for (size_t col: L2.getAvailable_cols()) {
-                if (L2.at(row_number2, col)) one_cols2.insert(col);
+        ull *rows = (ull *) (file->data() + sizeof(header));
+        storage = shared_ptr<ull>(file, rows);
+        ull last = width % CHUNK_SIZE ? ~0ULL << (width % CHUNK_SIZE) : 0;
+        for (size_t i = 0; i < height && chunks; i++) {
+            if ((row(i)[chunks - 1] & last) ||
+                any_of(row(i) + chunks, row(i) + stride, [](ull w) { return w != 0; })) {
+                cerr << "Bits outside of the matrix in row " << i << endl;
+                throw out_of_range("");
             }
         }
-    } else {
-        if (!L1_empty) {
-            row_number1 = *L1.getAvailable_rows().begin();
-            for (size_t col: L1.getAvailable_cols()) {
-                if (L1.at(row_number1, col)) one_cols1.insert(col);
+        if (header.column_stride == column_chunks) {
+            transposed = shared_ptr<ull>(file, rows + height * stride);
+            if (!columns_match_rows()) {
+                cerr << "Columns of the binary matrix file do not match its rows" << endl;
+                throw out_of_range("");
             }
+        } else {
+            transposed = allocate_words(width * column_chunks);
+            transpose();
+        }
+    }
+
+public:
+    BitMatrix() : height(0), width(0), chunks(0), stride(0), column_chunks(0) {}
+
+    BitMatrix(istream &in, size_t n, size_t m) : height(n), width(m) {
+        read(in);
+    }
+
+    /**
+     * Random n x m matrix whose entries are 1 with probability density. The
+     * same seed gives the same matrix on every platform.
+     */
+    BitMatrix(size_t n, size_t m, double density, ull seed) : height(n),
+                                                              width(m) {
+        mt19937_64 random(seed);
+        bool full = density >= 1;
+        ull threshold = full || density <= 0 ? 0 : ull(density * 18446744073709551616.0);
+        allocate();
+        for (size_t i = 0; i < height; i++) {
+            ull *dst = storage.get() + i * stride;
+            for (size_t j = 0; j < width; j++)
+                dst[j / CHUNK_SIZE] |= ull(full || random() < threshold) << (j % CHUNK_SIZE);
+        }
+        transpose();
+    }
+
+    /*! Matrix of 0/1 entries given row by row, all rows of the same length*/
+    explicit BitMatrix(const vector<vector<int>> &entries) :
+            height(entries.size()), width(entries.empty() ? 0 : entries[0].size()) {
+        allocate();
+        for (size_t i = 0; i < height; i++) {
+            if (entries[i].size() != width) {
+                cerr << "Row " << i << " has " << entries[i].size()
+                     << " values instead of " << width << endl;
+                throw length_error("");
+            }
+            ull *dst = storage.get() + i * stride;
+            for (size_t j = 0; j < width; j++) {
+                if (entries[i][j] != 0 && entries[i][j] != 1) {
+                    cerr << "Incorrect value encountered in input matrix: "
+                         << entries[i][j] << endl;
+                    throw out_of_range("");
+                }
+                dst[j / CHUNK_SIZE] |= ull(entries[i][j]) << (j % CHUNK_SIZE);
+            }
+        }
+        transpose();
+    }
+
+    /*! Matrix of the rows of top followed by the rows of bottom*/
+    BitMatrix(const BitMatrix &top, const BitMatrix &bottom) :
+            height(top.height + bottom.height), width(top.width) {
+        if (bottom.width != top.width) {
+            cerr << "Matrices should be of equal width" << endl;
+            throw length_error("");
+        }
+        allocate();
+        for (size_t i = 0; i < height; i++) {
+            const ull *src = i < top.height ? top.row(i) : bottom.row(i - top.height);
+            memcpy(storage.get() + i * stride, src, chunks * sizeof(ull));
+        }
+        transpose();
+    }
+
+    /*! Submatrix of source made of the given rows and columns, in their order*/
+    BitMatrix(const BitMatrix &source, const vector<size_t> &rows,
+              const vector<size_t> &cols) : height(rows.size()),
+                                            width(cols.size()) {
+        allocate();
+        for (size_t i = 0; i < height; i++) {
+            ull *dst = storage.get() + i * stride;
+            for (size_t j = 0; j < width; j++)
+                dst[j / CHUNK_SIZE] |= ull(source.at(rows[i], cols[j])) << (j % CHUNK_SIZE);
+        }
+        transpose();
+    }
+
+    BitMatrix(const string &filename, size_t n, size_t m) : height(n),
+                                                            width(m) {
+        MappedFile file(filename);
+        parse(file.data(), file.data() + file.size());
+    }
+
+    /**
+     * Loads a matrix with the shape given by the file: either a text file of
+     * 0/1 values with one row per line, or a binary file written by save(),
+     * which is mapped into memory and used without copying.
+     */
+    explicit BitMatrix(const string &filename) {
+        shared_ptr<MappedFile> file = make_shared<MappedFile>(filename);
+        if (file->size() >= sizeof(MatrixFileHeader) &&
+            memcmp(file->data(), MATRIX_FILE_MAGIC, sizeof(MATRIX_FILE_MAGIC)) == 0) {
+            map_binary(file);
+            return;
+        }
+        pair<size_t, size_t> shape = text_shape(file->data(),
+                                                file->data() + file->size());
+        height = shape.first;
+        width = shape.second;
+        parse(file->data(), file->data() + file->size());
+    }
+
+    /*! Writes the matrix to a binary file that BitMatrix(filename) maps back*/
+    void save(const string &filename) const {
+        MatrixFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MATRIX_FILE_MAGIC, sizeof(header.magic));
+        header.height = height;
+        header.width = width;
+        header.stride = stride;
+        header.column_stride = column_chunks;
+        FILE *out = fopen(filename.c_str(), "wb");
+        if (out == nullptr) {
+            cerr << "Error: " << strerror(errno) << endl;
+            cerr << "Failed to open output file" << endl;
+            throw bad_exception();
+        }
+        bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+        ok = ok && fwrite(storage.get(), sizeof(ull), height * stride, out) ==
+                   height * stride;
+        ok = ok && fwrite(transposed.get(), sizeof(ull), width * column_chunks,
+                          out) == width * column_chunks;
+        if (fclose(out) != 0 || !ok) {
+            cerr << "Error: " << strerror(errno) << endl;
+            throw runtime_error("Failed to write matrix file");
+        }
+    }
+
+    size_t getHeight() const {
+        return height;
+    }
+
+    size_t getWidth() const {
+        return width;
+    }
+
+    size_t getChunks() const {
+        return chunks;
+    }
+
+    size_t getStride() const {
+        return stride;
+    }
+
+    /*! Pointer to the getChunks() words of row i*/
+    const ull *row(size_t i) const {
+        return storage.get() + i * stride;
+    }
+
+    size_t getColumn_chunks() const {
+        return column_chunks;
+    }
+
+    /*! Hash of the shape and the rows, to tell whether two matrices differ*/
+    ull fingerprint() const {
+        ull h = height * 0x9E3779B97F4A7C15ULL ^ width;
+        for (size_t i = 0; i < height; i++) {
+            for (size_t w = 0; w < chunks; w++) {
+                ull word = row(i)[w] + (i * chunks + w) * 0x9E3779B97F4A7C15ULL;
+                word = (word ^ (word >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                word = (word ^ (word >> 27)) * 0x94D049BB133111EBULL;
+                h = (h ^ word ^ (word >> 31)) * 0xFF51AFD7ED558CCDULL;
+                h ^= h >> 33;
+            }
+        }
+        return h;
+    }
+
+    /*! Pointer to the getColumn_chunks() words of column j*/
+    const ull *column(size_t j) const {
+        return transposed.get() + j * column_chunks;
+    }
+
+    int at(size_t i, size_t j) const {
+        return int((row(i)[j / CHUNK_SIZE] >> (j % CHUNK_SIZE)) & 1ULL);
+    }
+
+    friend ostream &operator<<(ostream &os, const BitMatrix &bm);
+};
+
+inline ostream &operator<<(ostream &os, const BitMatrix &bm) {
+    cout << "Bit matrix with shape (" << bm.height << ", " << bm.width << ")"
+         << endl << endl;
+    for (size_t i = 0; i < bm.height; i++) {
+        for (size_t j = 0; j < bm.width; j++) {
+            cout << bm.at(i, j) << ' ';
+        }
+        cout << endl;
+    }
+    cout << endl;
+    return os;
+}
+
+/**
+ * Binary matrix together with the state of a search over it: the rows that
+ * are not covered yet, the columns that may still be selected, the selected
+ * columns and the supporting rows of every selected column.
+ *
+ * The state is kept in one array of words and is modified in place. Every
+ * modified word is recorded in an undo trail, so a branch of the search is
+ * taken with select_column() and undone with rollback(mark()) instead of
+ * copying the whole object.
+ *
+ * The number of available rows having 1 in every column and the weight of
+ * every row on the available columns are part of the state as well. They
+ * are updated only for the rows and columns that get deleted, so zero
+ * columns and the lightest row are found without scanning the matrix.
+ */
+class PartialBitMatrix : public BitMatrix {
+    enum {
+        CUR_HEIGHT,
+        CUR_WIDTH,
+        DEPTH,
+        SCALARS,
+    };
+
+    /*! Bit sets and counters of the search state*/
+    vector<ull> state;
+    /*! Previous values of the modified words of state*/
+    vector<pair<size_t, ull>> trail;
+    /*! Candidate columns of every search depth*/
+    vector<ull> frames;
+    /*! Columns whose count dropped to zero since they were last deleted*/
+    vector<size_t> zero_columns;
+    /*! Scratch space of delete_wider_rows()*/
+    vector<size_t> order;
+    vector<size_t> buckets;
+    vector<ull> masked_rows;
+    size_t row_chunks;
+    /*! Offsets of the parts of state*/
+    size_t available_rows;
+    size_t available_cols;
+    size_t selected_cols;
+    size_t covered_rows;
+    size_t supporting_rows;
+    size_t column_counts;
+    size_t row_weights;
+    size_t scalars;
+
+    void assign(size_t offset, ull value) {
+        if (state[offset] != value) {
+            trail.emplace_back(offset, state[offset]);
+            state[offset] = value;
+        }
+    }
+
+    bool test(size_t offset, size_t k) const {
+        return bool((state[offset + k / CHUNK_SIZE] >> (k % CHUNK_SIZE)) & 1ULL);
+    }
+
+    void init() {
+        row_chunks = (getHeight() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        available_rows = 0;
+        available_cols = available_rows + row_chunks;
+        selected_cols = available_cols + getChunks();
+        covered_rows = selected_cols + getChunks();
+        supporting_rows = covered_rows + row_chunks;
+        column_counts = supporting_rows + getWidth() * row_chunks;
+        row_weights = column_counts + getWidth();
+        scalars = row_weights + getHeight();
+        state.assign(scalars + SCALARS, 0);
+        for (size_t i = 0; i < getHeight(); i++) {
+            state[available_rows + i / CHUNK_SIZE] |= 1ULL << (i % CHUNK_SIZE);
+            for (size_t j = 0; j < getWidth(); j++) {
+                if (at(i, j)) {
+                    state[column_counts + j]++;
+                    state[row_weights + i]++;
+                }
+            }
+        }
+        zero_columns.reserve(getWidth());
+        for (size_t j = 0; j < getWidth(); j++) {
+            state[available_cols + j / CHUNK_SIZE] |= 1ULL << (j % CHUNK_SIZE);
+            if (state[column_counts + j] == 0) zero_columns.push_back(j);
+        }
+        state[scalars + CUR_HEIGHT] = getHeight();
+        state[scalars + CUR_WIDTH] = getWidth();
+
+        frames.assign((getWidth() + 1) * getChunks(), 0);
+        order.assign(getHeight(), 0);
+        buckets.assign(getWidth() + 2, 0);
+        masked_rows.assign(getHeight() * getChunks(), 0);
+        trail.reserve(state.size());
+
+        update_matrix();
+        trail.clear();
+    }
+
+    /**
+     * Rows of col stop being supporting for the selected columns. The rows of
+     * col that no selected column covers become its own supporting rows.
+     *
+     * The kernels below are templates on the number of words of a column (R)
+     * or of a row (C). They are instantiated for 1, 2 and 4 words, where the
+     * loops are unrolled, and for 0, which reads the number from the matrix.
+     * The public methods pick the instantiation with dispatch_words().
+     */
+    template<size_t R>
+    void update_support_rows(size_t col) {
+        size_t words = fixed_words<R>(row_chunks);
+        const ull *one_rows = column(col);
+        for (size_t entry: getSelected_cols()) {
+            size_t offset = supporting_rows + entry * row_chunks;
+            for (size_t w = 0; w < words; w++) {
+                if (state[offset + w] & one_rows[w])
+                    assign(offset + w, state[offset + w] & ~one_rows[w]);
+            }
+        }
+        for (size_t w = 0; w < words; w++) {
+            assign(supporting_rows + col * row_chunks + w,
+                   one_rows[w] & ~state[covered_rows + w]);
+            assign(covered_rows + w, state[covered_rows + w] | one_rows[w]);
+        }
+    }
+
+    /*! Removes an available row and updates the counts of its columns*/
+    template<size_t C>
+    void remove_row(size_t row) {
+        size_t w = row / CHUNK_SIZE;
+        assign(available_rows + w, state[available_rows + w] & ~(1ULL << (row % CHUNK_SIZE)));
+        assign(scalars + CUR_HEIGHT, state[scalars + CUR_HEIGHT] - 1);
+        const ull *words = this->row(row);
+        for (size_t c = 0; c < fixed_words<C>(getChunks()); c++) {
+            ull bits = words[c] & state[available_cols + c];
+            while (bits) {
+                size_t j = c * CHUNK_SIZE + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                assign(column_counts + j, state[column_counts + j] - 1);
+                if (state[column_counts + j] == 0) zero_columns.push_back(j);
+            }
+        }
+    }
+
+    /*! Removes an available column and updates the weights of its rows*/
+    template<size_t R>
+    void remove_column(size_t col) {
+        size_t w = col / CHUNK_SIZE;
+        assign(available_cols + w, state[available_cols + w] & ~(1ULL << (col % CHUNK_SIZE)));
+        assign(scalars + CUR_WIDTH, state[scalars + CUR_WIDTH] - 1);
+        const ull *one_rows = column(col);
+        for (size_t w = 0; w < fixed_words<R>(row_chunks); w++) {
+            ull bits = one_rows[w] & state[available_rows + w];
+            while (bits) {
+                size_t i = w * CHUNK_SIZE + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                assign(row_weights + i, state[row_weights + i] - 1);
+            }
+        }
+    }
+
+    template<size_t R>
+    void delete_zero_columns() {
+        for (size_t j: zero_columns) {
+            if (state[column_counts + j] == 0 && test(available_cols, j)) {
+                remove_column<R>(j);
+            }
+        }
+        zero_columns.clear();
+    }
+
+    /**
+     * Deletes every available row that contains another available row on
+     * the available columns. Of several equal rows the one with the smallest
+     * number is kept.
+     *
+     * select_column() does not call it: the rows it leaves never contain the
+     * selected column, and a zero column is in none of them, so deleting
+     * these columns cannot make one remaining row contain another. The rows
+     * minimized by init() stay minimal below the root, up to the columns the
+     * search excludes; a row that contains another one only on those is
+     * covered along with it, so the results do not change.
+     *
+     * Rows are ordered by their weight with a counting sort, so a row can
+     * only contain the rows placed before it. Every row is then tested
+     * against the rows kept so far, which are stored one after another in
+     * masked_rows.
+     */
+    template<size_t C>
+    void delete_wider_rows() {
+        size_t chunks = fixed_words<C>(getChunks());
+        const ull *mask = state.data() + available_cols;
+        size_t count = 0;
+
+        fill(buckets.begin(), buckets.end(), 0);
+        for (size_t i: getAvailable_rows()) {
+            buckets[state[row_weights + i] + 1]++;
+            count++;
+        }
+        if (count < 2) return;
+        for (size_t k = 1; k < buckets.size(); k++)
+            buckets[k] += buckets[k - 1];
+        for (size_t i: getAvailable_rows())
+            order[buckets[state[row_weights + i]]++] = i;
+
+        size_t kept = 0;
+        for (size_t p = 0; p < count; p++) {
+            const ull *words = row(order[p]);
+            ull *masked = masked_rows.data() + kept * chunks;
+            for (size_t w = 0; w < chunks; w++)
+                masked[w] = words[w] & mask[w];
+            bool wider = false;
+            for (size_t k = 0; k < kept && !wider; k++)
+                wider = is_subset<C>(masked_rows.data() + k * chunks, masked, chunks);
+            if (wider) {
+                remove_row<C>(order[p]);
+            } else {
+                kept++;
+            }
+        }
+    }
+
+    template<size_t R, size_t C>
+    void delete_column(size_t col, bool outside) {
+        size_t w = col / CHUNK_SIZE;
+        ull bit = 1ULL << (col % CHUNK_SIZE);
+        if (state[available_cols + w] & bit) remove_column<R>(col);
+        if (outside && !(state[selected_cols + w] & bit)) {
+            assign(selected_cols + w, state[selected_cols + w] | bit);
+            assign(scalars + DEPTH, state[scalars + DEPTH] + 1);
+        }
+    }
+
+    template<size_t R, size_t C>
+    void update_matrix() {
+        delete_zero_columns<R>();
+        delete_wider_rows<C>();
+    }
+
+    template<size_t R, size_t C>
+    bool check_support_rows(size_t col) const {
+        size_t words = fixed_words<R>(row_chunks);
+        const ull *one_rows = column(col);
+        const ull *selected = state.data() + selected_cols;
+        for (size_t c = 0; c < fixed_words<C>(getChunks()); c++) {
+            for (ull bits = selected[c]; bits; bits &= bits - 1) {
+                size_t entry = c * CHUNK_SIZE + __builtin_ctzll(bits);
+                if (is_subset<R>(state.data() + supporting_rows + entry * row_chunks,
+                                 one_rows, words))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    template<size_t R, size_t C>
+    void select_column(size_t col) {
+        const ull *one_rows = column(col);
+        for (size_t w = 0; w < fixed_words<R>(row_chunks); w++) {
+            ull covered = state[available_rows + w] & one_rows[w];
+            while (covered) {
+                remove_row<C>(w * CHUNK_SIZE + __builtin_ctzll(covered));
+                covered &= covered - 1;
+            }
+        }
+        update_support_rows<R>(col);
+        delete_column<R, C>(col, true);
+        delete_zero_columns<R>();
+    }
+
+    template<size_t C>
+    BitsetView branch_columns(size_t row) {
+        ull *frame = frames.data() + state[scalars + DEPTH] * getChunks();
+        const ull *words = this->row(row);
+        for (size_t w = 0; w < fixed_words<C>(getChunks()); w++)
+            frame[w] = words[w] & state[available_cols + w];
+        return BitsetView(frame, getWidth());
+    }
+
+    /*! Calls f(Words<R>(), Words<C>()) for the kernels of this matrix*/
+    template<class F>
+    auto dispatch(F f) const -> decltype(f(Words<0>(), Words<0>())) {
+        size_t chunks = getChunks();
+        return dispatch_words(row_chunks, [chunks, &f](auto R) {
+            return dispatch_words(chunks, [&f, R](auto C) {
+                return f(R, C);
+            });
+        });
+    }
+
+public:
+    PartialBitMatrix(istream &in, size_t n, size_t m) : BitMatrix(in, n, m) {
+        init();
+    }
+
+    PartialBitMatrix(const string &filename, size_t n, size_t m) : BitMatrix(
+            filename, n, m) {
+        init();
+    }
+
+    explicit PartialBitMatrix(const string &filename) : BitMatrix(filename) {
+        init();
+    }
+
+    PartialBitMatrix(size_t n, size_t m, double density, ull seed) :
+            BitMatrix(n, m, density, seed) {
+        init();
+    }
+
+    PartialBitMatrix(const BitMatrix &source, const vector<size_t> &rows,
+                     const vector<size_t> &cols) : BitMatrix(source, rows, cols) {
+        init();
+    }
+
+    explicit PartialBitMatrix(const vector<vector<int>> &entries) : BitMatrix(entries) {
+        init();
+    }
+
+    PartialBitMatrix(const BitMatrix &top, const BitMatrix &bottom) : BitMatrix(top, bottom) {
+        init();
+    }
+
+    PartialBitMatrix() : BitMatrix() {
+        init();
+    }
+
+    /**
+     * Becomes a copy of source, sharing its bits as a copy does, but keeps
+     * the buffers of this matrix where they are large enough. The undo trail
+     * starts empty.
+     */
+    void reset(const PartialBitMatrix &source) {
+        BitMatrix::operator=(source);
+        row_chunks = source.row_chunks;
+        available_rows = source.available_rows;
+        available_cols = source.available_cols;
+        selected_cols = source.selected_cols;
+        covered_rows = source.covered_rows;
+        supporting_rows = source.supporting_rows;
+        column_counts = source.column_counts;
+        row_weights = source.row_weights;
+        scalars = source.scalars;
+        state = source.state;
+        zero_columns = source.zero_columns;
+        zero_columns.reserve(getWidth());
+        trail.clear();
+        trail.reserve(state.size());
+        frames.resize((getWidth() + 1) * getChunks());
+        order.resize(getHeight());
+        buckets.resize(getWidth() + 2);
+        masked_rows.resize(getHeight() * getChunks());
+    }
+
+    void delete_column(size_t col, bool outside = true) {
+        if (col >= this->getWidth()) {
+            cerr << "Invalid column number" << endl;
+            throw out_of_range("");
+        }
+        dispatch([&](auto R, auto C) {
+            delete_column<decltype(R)::value, decltype(C)::value>(col, outside);
+        });
+    }
+
+    void delete_row(size_t row) {
+        if (row >= this->getHeight()) {
+            cerr << "Invalid row number" << endl;
+            throw out_of_range("");
+        }
+        if (!test(available_rows, row)) return;
+        dispatch([&](auto, auto C) {
+            remove_row<decltype(C)::value>(row);
+        });
+    }
+
+    void update_matrix() {
+        dispatch([&](auto R, auto C) {
+            update_matrix<decltype(R)::value, decltype(C)::value>();
+        });
+    }
+
+    /**
+     * Checks that adding col to the selected columns keeps all of them
+     * irredundant, i.e. that col does not cover all supporting rows of some
+     * selected column.
+     */
+    bool check_support_rows(size_t col) const {
+        return dispatch([&](auto R, auto C) {
+            return check_support_rows<decltype(R)::value, decltype(C)::value>(col);
+        });
+    }
+
+    /**
+     * Adds col to the coverage: deletes the rows it covers, updates the
+     * supporting rows and reduces the remaining matrix.
+     */
+    void select_column(size_t col) {
+        dispatch([&](auto R, auto C) {
+            select_column<decltype(R)::value, decltype(C)::value>(col);
+        });
+    }
+
+    /*! Position in the undo trail to return to with rollback()*/
+    size_t mark() const {
+        return trail.size();
+    }
+
+    /*! Undoes all changes made after mark was taken*/
+    void rollback(size_t mark) {
+        while (trail.size() > mark) {
+            state[trail.back().first] = trail.back().second;
+            trail.pop_back();
+        }
+    }
+
+    /**
+     * Available columns having 1 in the given row. The result is stored in a
+     * buffer of the current search depth, so it stays valid while deeper
+     * branches are explored.
+     */
+    BitsetView branch_columns(size_t row) {
+        return dispatch([&](auto, auto C) {
+            return branch_columns<decltype(C)::value>(row);
+        });
+    }
+
+    size_t getCur_height() const {
+        return state[scalars + CUR_HEIGHT];
+    }
+
+    size_t getCur_width() const {
+        return state[scalars + CUR_WIDTH];
+    }
+
+    BitsetView getAvailable_rows() const {
+        return BitsetView(state.data() + available_rows, getHeight());
+    }
+
+    BitsetView getAvailable_cols() const {
+        return BitsetView(state.data() + available_cols, getWidth());
+    }
+
+    BitsetView getSelected_cols() const {
+        return BitsetView(state.data() + selected_cols, getWidth());
+    }
+
+    /*! Number of available rows having 1 in column col*/
+    size_t getColumn_count(size_t col) const {
+        return state[column_counts + col];
+    }
+
+    /*! Number of available columns where row has 1*/
+    size_t getRow_weight(size_t row) const {
+        return state[row_weights + row];
+    }
+
+    /**
+     * Hash of the available rows, the available columns and the selected
+     * columns. The rest of the state follows from them, so equal states
+     * reached by selecting the columns in different orders hash equally.
+     */
+    ull state_hash(ull seed) const {
+        ull h = seed;
+        for (size_t w = 0; w < covered_rows; w++) {
+            ull word = state[w] + w * 0x9E3779B97F4A7C15ULL;
+            word = (word ^ (word >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            word = (word ^ (word >> 27)) * 0x94D049BB133111EBULL;
+            h = (h ^ word ^ (word >> 31)) * 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 33;
+        }
+        return h;
+    }
+
+    pair<size_t, size_t> getLightestRow() const {
+        size_t min = getWidth() + 1, min_n = 0;
+        for (auto row: getAvailable_rows()) {
+            if (state[row_weights + row] < min) {
+                min = state[row_weights + row];
+                min_n = row;
+            }
+        }
+        return {min_n, min};
+    }
+
+    friend ostream &operator<<(ostream &os, const PartialBitMatrix &bm);
+};
+
+inline ostream &operator<<(ostream &os, const PartialBitMatrix &bm) {
+    cout << "Partial bit matrix with initial shape (" << bm.getHeight() << ", "
+         << bm.getWidth() << ")" << endl;
+    cout << "Current shape (" << bm.getCur_height() << ", "
+         << bm.getCur_width() << ")" << endl << endl;
+    for (auto i: bm.getAvailable_rows()) {
+        for (auto j: bm.getAvailable_cols()) {
+            cout << bm.at(i, j) << ' ';
+        }
+        cout << endl;
+    }
+    cout << "Available cols: [";
+    for (auto entry: bm.getAvailable_cols()) cout << entry << ",";
+    cout << ']' << endl;
+    cout << "Available rows: [";
+    for (auto entry: bm.getAvailable_rows()) cout << entry << ",";
+    cout << ']' << endl;
+    cout << "Selected cols: [";
+    for (auto entry: bm.getSelected_cols()) cout << entry << ",";
+    cout << ']' << endl;
+    cout << endl;
+    return os;
+}
+
+/**
+ * Chooses the row an engine branches on. choose() returns an available row
+ * of a non-empty matrix and a score; D1 branches in the matrix whose row has
+ * the larger score. Every worker of a parallel run uses its own clone.
+ */
+class BranchingStrategy {
+public:
+    virtual ~BranchingStrategy() {}
+
+    virtual const char *name() const = 0;
+
+    virtual pair<size_t, size_t> choose(const PartialBitMatrix &A) = 0;
+
+    virtual unique_ptr<BranchingStrategy> clone() const = 0;
+};
+
+/*! Available row with the smallest number, the choice of weights = false*/
+class FirstRowStrategy : public BranchingStrategy {
+public:
+    const char *name() const override {
+        return "first";
+    }
+
+    pair<size_t, size_t> choose(const PartialBitMatrix &A) override {
+        size_t row = *A.getAvailable_rows().begin();
+        return {row, SIZE_MAX - row};
+    }
+
+    unique_ptr<BranchingStrategy> clone() const override {
+        return unique_ptr<BranchingStrategy>(new FirstRowStrategy(*this));
+    }
+};
+
+/**
+ * Row with the fewest available columns, the choice of weights = true. The
+ * score is the weight of the row, so D1 keeps branching in the matrix whose
+ * lightest row is heavier, as it always did.
+ */
+class LightestRowStrategy : public BranchingStrategy {
+public:
+    const char *name() const override {
+        return "lightest";
+    }
+
+    pair<size_t, size_t> choose(const PartialBitMatrix &A) override {
+        return A.getLightestRow();
+    }
+
+    unique_ptr<BranchingStrategy> clone() const override {
+        return unique_ptr<BranchingStrategy>(new LightestRowStrategy(*this));
+    }
+};
+
+/**
+ * Lightest row; among rows of equal weight the one whose columns cover the
+ * most available rows, so that the branches remove more rows at once.
+ */
+class FrequentColumnsStrategy : public BranchingStrategy {
+public:
+    const char *name() const override {
+        return "lightest-frequent";
+    }
+
+    pair<size_t, size_t> choose(const PartialBitMatrix &A) override {
+        size_t best = 0, best_weight = SIZE_MAX, best_frequency = 0;
+        const ull *cols = A.getAvailable_cols().words();
+        for (size_t row: A.getAvailable_rows()) {
+            size_t weight = A.getRow_weight(row);
+            if (weight > best_weight) continue;
+            size_t frequency = 0;
+            for (size_t col: BitsetView(A.row(row), A.getWidth()))
+                if (cols[col / CHUNK_SIZE] >> (col % CHUNK_SIZE) & 1)
+                    frequency += A.getColumn_count(col);
+            if (weight < best_weight || frequency > best_frequency) {
+                best = row;
+                best_weight = weight;
+                best_frequency = frequency;
+            }
+        }
+        return {best, best_weight};
+    }
+
+    unique_ptr<BranchingStrategy> clone() const override {
+        return unique_ptr<BranchingStrategy>(new FrequentColumnsStrategy(*this));
+    }
+};
+
+/**
+ * Row with the fewest columns that can still be selected without making a
+ * selected column redundant, that is, the fewest branches that survive the
+ * supporting row check. Ties go to the lighter row. The score is the number
+ * of such columns.
+ */
+class HardestToSupportStrategy : public BranchingStrategy {
+public:
+    const char *name() const override {
+        return "hardest-support";
+    }
+
+    pair<size_t, size_t> choose(const PartialBitMatrix &A) override {
+        size_t best = 0, best_count = SIZE_MAX, best_weight = SIZE_MAX;
+        const ull *cols = A.getAvailable_cols().words();
+        for (size_t row: A.getAvailable_rows()) {
+            size_t count = 0;
+            for (size_t col: BitsetView(A.row(row), A.getWidth())) {
+                if ((cols[col / CHUNK_SIZE] >> (col % CHUNK_SIZE) & 1) &&
+                    A.check_support_rows(col) && ++count > best_count)
+                    break;
+            }
+            size_t weight = A.getRow_weight(row);
+            if (count < best_count || (count == best_count && weight < best_weight)) {
+                best = row;
+                best_count = count;
+                best_weight = weight;
+                if (count == 0) break;
+            }
+        }
+        return {best, best_count};
+    }
+
+    unique_ptr<BranchingStrategy> clone() const override {
+        return unique_ptr<BranchingStrategy>(new HardestToSupportStrategy(*this));
+    }
+};
+
+/*! Lightest row, with ties broken at random*/
+class RandomRowStrategy : public BranchingStrategy {
+    mt19937_64 generator;
+    vector<size_t> lightest;
+
+public:
+    explicit RandomRowStrategy(unsigned long long seed = 0) : generator(seed) {}
+
+    const char *name() const override {
+        return "random";
+    }
+
+    pair<size_t, size_t> choose(const PartialBitMatrix &A) override {
+        size_t min = SIZE_MAX;
+        lightest.clear();
+        for (size_t row: A.getAvailable_rows()) {
+            size_t weight = A.getRow_weight(row);
+            if (weight < min) {
+                min = weight;
+                lightest.clear();
+            }
+            if (weight == min) lightest.push_back(row);
+        }
+        return {lightest[generator() % lightest.size()], min};
+    }
+
+    unique_ptr<BranchingStrategy> clone() const override {
+        return unique_ptr<BranchingStrategy>(new RandomRowStrategy(*this));
+    }
+};
+
+/*! Strategy behind the weights flag of the engines*/
+inline BranchingStrategy &branching_strategy(bool weights) {
+    static FirstRowStrategy first;
+    static LightestRowStrategy lightest;
+    if (weights) return lightest;
+    return first;
+}
+
+inline void print_results(set<pair<set<size_t>, set<size_t>>> &found_coverages) {
+    for (auto &cov_pair: found_coverages) {
+        printf("{");
+        for (auto entry: cov_pair.first) {
+            printf("%ld ", entry);
+        }
+        printf("}  {");
+        for (auto entry: cov_pair.second) {
+            printf("%ld ", entry);
+        }
+        printf("}\n");
+    }
+}
+
+/**
+ * Work-stealing scheduler of search tasks. A task is the path from the root
+ * of the search tree to the node to explore. Every worker takes tasks from
+ * the back of its own queue and steals from the front of the other queues,
+ * where the tasks closest to the root are, when its own queue is empty.
+ */
+class WorkStealingPool {
+public:
+    typedef vector<pair<int, size_t>> Task;
+
+private:
+    struct Queue {
+        mutex lock;
+        deque<Task> tasks;
+        atomic<size_t> size;
+
+        Queue() : size(0) {}
+    };
+
+    vector<unique_ptr<Queue>> queues;
+    /*! Tasks that are queued or running*/
+    atomic<size_t> pending;
+    /*! Workers that found no task to take*/
+    atomic<size_t> idle;
+
+    bool take(size_t worker, Task &task) {
+        for (size_t k = 0; k < queues.size(); k++) {
+            Queue &queue = *queues[(worker + k) % queues.size()];
+            if (queue.size.load(memory_order_relaxed) == 0) continue;
+            lock_guard<mutex> guard(queue.lock);
+            if (queue.tasks.empty()) continue;
+            if (k == 0) {
+                task = move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            queue.size--;
+            return true;
+        }
+        return false;
+    }
+
+public:
+    explicit WorkStealingPool(size_t threads) : pending(0), idle(0) {
+        if (threads == 0) threads = 1;
+        for (size_t i = 0; i < threads; i++) queues.emplace_back(new Queue());
+    }
+
+    size_t getThreads() const {
+        return queues.size();
+    }
+
+    /*! True if some worker waits for a task and worker has none queued*/
+    bool hungry(size_t worker) const {
+        return idle.load(memory_order_relaxed) > 0 &&
+               queues[worker]->size.load(memory_order_relaxed) == 0;
+    }
+
+    void push(size_t worker, Task task) {
+        pending++;
+        Queue &queue = *queues[worker];
+        lock_guard<mutex> guard(queue.lock);
+        queue.tasks.push_back(move(task));
+        queue.size++;
+    }
+
+    /**
+     * Runs body(worker, task) for the root task and for every task pushed
+     * while running, on getThreads() threads. Returns when all tasks are
+     * done.
+     */
+    template<class Body>
+    void run(const Task &root, Body body) {
+        push(0, root);
+        auto loop = [this, &body](size_t worker) {
+            Task task;
+            bool waiting = false;
+            while (true) {
+                if (take(worker, task)) {
+                    if (waiting) idle--;
+                    waiting = false;
+                    body(worker, task);
+                    pending--;
+                } else {
+                    if (pending.load() == 0) break;
+                    if (!waiting) idle++;
+                    waiting = true;
+                    this_thread::yield();
+                }
+            }
+            if (waiting) idle--;
+        };
+        vector<thread> threads;
+        for (size_t w = 1; w < queues.size(); w++) threads.emplace_back(loop, w);
+        loop(0);
+        for (auto &t: threads) t.join();
+    }
+};
+
+/**
+ * Receives the coverages found by an engine as soon as they are found.
+ * Coverages come as views of the words of the search state, so they are only
+ * valid during the call and have to be copied if they are kept.
+ */
+class CoverageVisitor {
+public:
+    virtual ~CoverageVisitor() {}
+
+    /*! Irredundant coverage found by dualization*/
+    virtual void visit(const BitsetView &) {}
+
+    /*! Pair of disjoint coverages found by D1_dualization, D2_dualization
+     * or combine*/
+    virtual void visit(const BitsetView &, const BitsetView &) {}
+};
+
+/**
+ * Prints every coverage as a {a b} line and every pair as a {a b}  {c d}
+ * line. Optionally counts the visited coverages in *count.
+ */
+class PrintVisitor : public CoverageVisitor {
+    bool print;
+    size_t *count;
+
+    static void print_coverage(const BitsetView &coverage) {
+        printf("{");
+        for (auto entry: coverage) {
+            printf("%ld ", entry);
+        }
+        printf("}");
+    }
+
+public:
+    explicit PrintVisitor(size_t *count = nullptr, bool print = true) :
+            print(print), count(count) {}
+
+    void visit(const BitsetView &coverage) override {
+        if (count) ++*count;
+        if (!print) return;
+        print_coverage(coverage);
+        printf("\n");
+    }
+
+    void visit(const BitsetView &first, const BitsetView &second) override {
+        if (count) ++*count;
+        if (!print) return;
+        print_coverage(first);
+        printf("  ");
+        print_coverage(second);
+        printf("\n");
+    }
+};
+
+/*! Saves coverages to a CoverageStore and pairs to a set of pairs of sets*/
+class SaveVisitor : public CoverageVisitor {
+    CoverageStore *coverages;
+    set<pair<set<size_t>, set<size_t>>> *found_coverages;
+
+public:
+    SaveVisitor(CoverageStore *coverages,
+                set<pair<set<size_t>, set<size_t>>> *found_coverages) :
+            coverages(coverages), found_coverages(found_coverages) {}
+
+    void visit(const BitsetView &coverage) override {
+        coverages->insert(coverage);
+    }
+
+    void visit(const BitsetView &first, const BitsetView &second) override {
+        found_coverages->insert({first.to_set(), second.to_set()});
+    }
+};
+
+/*! Counts coverages and pairs of coverages*/
+class CountVisitor : public CoverageVisitor {
+public:
+    size_t count;
+
+    CountVisitor() : count(0) {}
+
+    void visit(const BitsetView &) override {
+        count++;
+    }
+
+    void visit(const BitsetView &, const BitsetView &) override {
+        count++;
+    }
+};
+
+/*! Passes the coverages to another visitor, one call at a time*/
+class SynchronizedVisitor : public CoverageVisitor {
+    CoverageVisitor &visitor;
+    mutex lock;
+
+public:
+    explicit SynchronizedVisitor(CoverageVisitor &visitor) : visitor(visitor) {}
+
+    void visit(const BitsetView &coverage) override {
+        lock_guard<mutex> guard(lock);
+        visitor.visit(coverage);
+    }
+
+    void visit(const BitsetView &first, const BitsetView &second) override {
+        lock_guard<mutex> guard(lock);
+        visitor.visit(first, second);
+    }
+};
+
+/*! Runs statement only in builds with DUALIZATION_STATS*/
+#ifdef DUALIZATION_STATS
+#define SEARCH_STATS(statement) statement
+#else
+#define SEARCH_STATS(statement)
+#endif
+
+/**
+ * Counters of one worker of a search. The engines fill them only in builds
+ * with DUALIZATION_STATS; otherwise their hooks compile to nothing.
+ */
+struct SearchStats {
+    size_t nodes;
+    /*! Branches whose column failed check_support_rows*/
+    size_t rejected;
+    /*! Columns removed after the selections besides the selected column*/
+    size_t removed_cols;
+    /*! Nodes with rows left to cover but no branch to take*/
+    size_t dead_ends;
+    /*! Number of leaves by the number of columns of their coverage. The pairs
+     * D1 counts multiply out of independent matrices or take from a
+     * transposition table are not leaves of the search and are not in it*/
+    vector<size_t> leaves;
+    /*! Time spent in select_column and in check_support_rows*/
+    uint64_t minimize_ns;
+    uint64_t support_ns;
+
+    SearchStats() : nodes(0), rejected(0), removed_cols(0), dead_ends(0),
+                    minimize_ns(0), support_ns(0) {}
+
+    void add(const SearchStats &other) {
+        nodes += other.nodes;
+        rejected += other.rejected;
+        removed_cols += other.removed_cols;
+        dead_ends += other.dead_ends;
+        if (leaves.size() < other.leaves.size()) leaves.resize(other.leaves.size());
+        for (size_t d = 0; d < other.leaves.size(); d++) leaves[d] += other.leaves[d];
+        minimize_ns += other.minimize_ns;
+        support_ns += other.support_ns;
+    }
+
+    void write_json(ostream &out) const {
+        size_t total = 0;
+        for (size_t count: leaves) total += count;
+        out << "{\"nodes\": " << nodes << ", \"leaves\": " << total
+            << ", \"rejected_branches\": " << rejected << ", \"dead_ends\": "
+            << dead_ends << ", \"removed_cols\": " << removed_cols
+            << ", \"minimize_seconds\": " << minimize_ns / 1e9
+            << ", \"support_seconds\": " << support_ns / 1e9
+            << ", \"leaves_by_depth\": [";
+        for (size_t d = 0; d < leaves.size(); d++) out << (d ? ", " : "") << leaves[d];
+        out << "]}";
+    }
+};
+
+/**
+ * Statistics of the runs of the engines that have it set on their control.
+ * Every worker adds its counters when it is done.
+ */
+class SearchProfile {
+    mutable mutex lock;
+    SearchStats total;
+    vector<SearchStats> workers;
+
+public:
+    void add(const SearchStats &stats) {
+        lock_guard<mutex> guard(lock);
+        total.add(stats);
+        workers.push_back(stats);
+    }
+
+    void clear() {
+        lock_guard<mutex> guard(lock);
+        total = SearchStats();
+        workers.clear();
+    }
+
+    SearchStats getTotal() const {
+        lock_guard<mutex> guard(lock);
+        return total;
+    }
+
+    /*! Writes the totals and the counters of every worker as a JSON object*/
+    void write_json(ostream &out) const {
+        lock_guard<mutex> guard(lock);
+        out << "{\"enabled\": ";
+#ifdef DUALIZATION_STATS
+        out << "true";
+#else
+        out << "false";
+#endif
+        out << ", \"total\": ";
+        total.write_json(out);
+        out << ", \"workers\": [";
+        for (size_t w = 0; w < workers.size(); w++) {
+            out << (w ? ", " : "");
+            workers[w].write_json(out);
+        }
+        out << "]}";
+    }
+};
+
+/**
+ * Prints a line with the nodes visited, the throughput and the results found
+ * at most once every interval. A run on one thread also knows the share of
+ * the search tree it has explored, from which the time left is estimated.
+ */
+class SearchProgress {
+    ostream &out;
+    chrono::steady_clock::duration interval;
+    chrono::steady_clock::time_point start;
+    chrono::steady_clock::time_point last;
+    atomic<size_t> nodes;
+    mutex lock;
+
+public:
+    explicit SearchProgress(double seconds = 1, ostream &out = cerr) :
+            out(out), nodes(0) {
+        interval = chrono::duration_cast<chrono::steady_clock::duration>(
+                chrono::duration<double>(seconds));
+        restart();
+    }
+
+    /*! Starts the clock and the node count of another run*/
+    void restart() {
+        start = last = chrono::steady_clock::now();
+        nodes = 0;
+    }
+
+    /**
+     * Adds visited nodes and prints the line if it is time to. done is the
+     * share of the tree explored, or negative if it is not known.
+     */
+    void tick(size_t visited, double done, size_t found) {
+        size_t total = nodes += visited;
+        auto now = chrono::steady_clock::now();
+        if (now - last < interval || !lock.try_lock()) return;
+        if (now - last >= interval) {
+            last = now;
+            double elapsed = chrono::duration<double>(now - start).count();
+            ios::fmtflags flags = out.flags();
+            streamsize precision = out.precision();
+            out << fixed << setprecision(1) << "progress: " << elapsed << " s, "
+                << total << " nodes, " << setprecision(0)
+                << (elapsed > 0 ? total / elapsed : 0.0) << " nodes/s, "
+                << found << " found";
+            if (done > 0)
+                out << ", " << setprecision(1) << 100 * done << "% done, eta "
+                    << elapsed * (1 - done) / done << " s";
+            out << endl;
+            out.flags(flags);
+            out.precision(precision);
+        }
+        lock.unlock();
+    }
+};
+
+/**
+ * Limits of a run of an engine: the number of results, a wall-clock deadline
+ * and cancellation from another thread. The engines check it at every node
+ * and unwind without visiting anything else once a limit is hit. A run is
+ * stopped by its result limit only when a result beyond it turns up, so a
+ * run with exactly limit results is COMPLETE; an existence query instead
+ * stops at its first result. getStatus() tells afterwards whether the run
+ * was complete. A control may be shared by the workers of a parallel run.
+ */
+class SearchControl {
+public:
+    enum Status {
+        COMPLETE,
+        LIMIT_REACHED,
+        DEADLINE_PASSED,
+        CANCELLED,
+    };
+
+private:
+    enum { CLOCK_PERIOD = 256 };
+
+    size_t limit;
+    /*! Whether the run stops as soon as limit results are passed on*/
+    bool eager;
+    bool timed;
+    chrono::steady_clock::time_point deadline;
+    atomic<size_t> found;
+    atomic<int> status;
+    SearchProfile *profile;
+    SearchProgress *progress;
+
+    void stop(Status reason) {
+        int expected = COMPLETE;
+        status.compare_exchange_strong(expected, reason);
+    }
+
+public:
+    /*! Control with at most limit results, 0 for no limit*/
+    explicit SearchControl(size_t limit = 0) : limit(limit), eager(false), timed(false),
+                                                found(0), status(COMPLETE),
+                                                profile(nullptr),
+                                                progress(nullptr) {}
+
+    void setLimit(size_t results) {
+        limit = results;
+        eager = false;
+    }
+
+    /*! Stops at the first result with LIMIT_REACHED, whether more exist or not*/
+    void setExistence() {
+        limit = 1;
+        eager = true;
+    }
+
+    /*! Stops the runs still going on after time from now*/
+    void setDeadline(chrono::milliseconds time) {
+        timed = true;
+        deadline = chrono::steady_clock::now() + time;
+    }
+
+    /*! Collects the statistics of the runs, in builds with DUALIZATION_STATS*/
+    void setProfile(SearchProfile *stats) {
+        profile = stats;
+    }
+
+    /*! Reports the progress of the runs, in builds with DUALIZATION_STATS*/
+    void setProgress(SearchProgress *lines) {
+        progress = lines;
+    }
+
+    SearchProfile *getProfile() const {
+        return profile;
+    }
+
+    SearchProgress *getProgress() const {
+        return progress;
+    }
+
+    /*! Stops the current run. May be called from any thread*/
+    void cancel() {
+        stop(CANCELLED);
+    }
+
+    /*! Prepares the control for another run with the same limits*/
+    void reset() {
+        found = 0;
+        status = COMPLETE;
+    }
+
+    bool stopped() const {
+        return status.load(memory_order_relaxed) != COMPLETE;
+    }
+
+    /**
+     * Called by the engines at every node with the number of nodes the
+     * calling thread has visited. Reads the clock once every CLOCK_PERIOD
+     * nodes. Returns true if the run has to stop.
+     */
+    bool check(size_t nodes) {
+        if (stopped()) return true;
+        if (timed && nodes % CLOCK_PERIOD == 0 &&
+            chrono::steady_clock::now() >= deadline) {
+            stop(DEADLINE_PASSED);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Claims one more result. Returns false if the limit is already reached;
+     * only then is the run stopped, unless it is an existence query.
+     */
+    bool admit() {
+        size_t k = found.fetch_add(1, memory_order_relaxed);
+        if (limit && k >= limit) {
+            found.fetch_sub(1, memory_order_relaxed);
+            stop(LIMIT_REACHED);
+            return false;
+        }
+        if (eager && k + 1 == limit) stop(LIMIT_REACHED);
+        return true;
+    }
+
+    Status getStatus() const {
+        return (Status) status.load();
+    }
+
+    bool isComplete() const {
+        return getStatus() == COMPLETE;
+    }
+
+    /*! Number of results passed on since the last reset()*/
+    size_t getFound() const {
+        return found.load();
+    }
+};
+
+/**
+ * Settings and result sink of one run of an engine. In a parallel run every
+ * worker has its own copy.
+ */
+struct Search {
+    BranchingStrategy *strategy;
+    CoverageVisitor *visitor;
+    /*! Columns selected on the way from the root, with the matrix (0 or 1)
+     * they were selected in, and columns excluded from matrix 0 or 1, marked
+     * 2 or 3*/
+    WorkStealingPool::Task path;
+    WorkStealingPool *pool;
+    size_t worker;
+    /*! Number of nodes of the search tree visited*/
+    size_t nodes;
+    /*! Number of results found while there is no visitor*/
+    count_t count;
+    SearchControl *control;
+    /*! Whether the results count against the result limit of control*/
+    bool limited;
+#ifdef DUALIZATION_STATS
+    enum { PROGRESS_PERIOD = 1 << 12 };
+
+    SearchStats stats;
+    /*! Branches started and all branches of every node of the path*/
+    vector<pair<size_t, size_t>> frames;
+    /*! Number of nodes handed over to the pool*/
+    size_t handed;
+    /*! Number of nodes already passed to the progress line*/
+    size_t published;
+
+    static uint64_t clock() {
+        return chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /*! Share of the search tree explored, negative in a parallel run*/
+    double done() const {
+        if (pool) return -1;
+        double done = 0, share = 1;
+        for (auto &frame: frames) {
+            if (frame.first == 0) break;
+            share /= frame.second;
+            done += share * (frame.first - 1);
+        }
+        return done;
+    }
+
+    void publish() {
+        control->getProgress()->tick(nodes - published, done(), control->getFound());
+        published = nodes;
+    }
+
+    /*! Counts a leaf whose coverage has depth columns*/
+    void leaf(size_t depth) {
+        if (stats.leaves.size() <= depth) stats.leaves.resize(depth + 1);
+        stats.leaves[depth]++;
+    }
+#endif
+
+    Search(BranchingStrategy *strategy, CoverageVisitor *visitor,
+           SearchControl *control = nullptr) :
+            strategy(strategy), visitor(visitor), pool(nullptr), worker(0),
+            nodes(0), count(0), control(control), limited(true) {
+        SEARCH_STATS(handed = published = 0);
+    }
+
+#ifdef DUALIZATION_STATS
+    /*! Passes the counters to the profile and the progress line of control*/
+    ~Search() {
+        if (control == nullptr || nodes == 0) return;
+        stats.nodes = nodes;
+        if (control->getProfile()) control->getProfile()->add(stats);
+        if (control->getProgress()) publish();
+    }
+#endif
+
+    /*! Counts a node. Returns false if the run has to stop*/
+    bool enter() {
+        nodes++;
+        SEARCH_STATS(if (control && control->getProgress() &&
+                         nodes % PROGRESS_PERIOD == 0) publish());
+        return control == nullptr || !control->check(nodes);
+    }
+
+    /*! L.check_support_rows(col), timed in builds with DUALIZATION_STATS*/
+    bool supported(const PartialBitMatrix &L, size_t col) {
+#ifdef DUALIZATION_STATS
+        uint64_t start = clock();
+        bool admitted = L.check_support_rows(col);
+        stats.support_ns += clock() - start;
+        if (!admitted) stats.rejected++;
+        return admitted;
+#else
+        return L.check_support_rows(col);
+#endif
+    }
+
+    /*! L.select_column(col), timed in builds with DUALIZATION_STATS*/
+    void select(PartialBitMatrix &L, size_t col) {
+#ifdef DUALIZATION_STATS
+        uint64_t start = clock();
+        size_t width = L.getCur_width() - 1;
+        L.select_column(col);
+        stats.removed_cols += width - L.getCur_width();
+        stats.minimize_ns += clock() - start;
+#else
+        L.select_column(col);
+#endif
+    }
+
+    /**
+     * Takes col out of the columns the matrix side may select below the
+     * current node. A node excludes every branch column once its turn is
+     * over, so a later branch does not reach a coverage again that contains
+     * the column of an earlier one.
+     */
+    void exclude(PartialBitMatrix &L, int side, size_t col) {
+        L.delete_column(col, false);
+        path.emplace_back(side + 2, col);
+    }
+
+    bool stopped() const {
+        return control != nullptr && control->stopped();
+    }
+
+    /*! Checks that one more result may be passed to the visitor*/
+    bool admit() {
+        return control == nullptr || !limited || control->admit();
+    }
+
+    /*! Passes a coverage to the visitor or, without one, only counts it*/
+    void report(const BitsetView &coverage) {
+        SEARCH_STATS(leaf(coverage.count()));
+        if (!admit()) return;
+        if (visitor) visitor->visit(coverage);
+        else count++;
+    }
+
+    void report(const BitsetView &first, const BitsetView &second) {
+        SEARCH_STATS(leaf(first.count() + second.count()));
+        if (!admit()) return;
+        if (visitor) visitor->visit(first, second);
+        else count++;
+    }
+
+    /**
+     * Hands the node at the end of path over to the pool if some worker is
+     * idle. Returns false if the caller has to explore it itself.
+     */
+    bool split() {
+        if (pool == nullptr || !pool->hungry(worker)) return false;
+        pool->push(worker, path);
+        SEARCH_STATS(handed++);
+        return true;
+    }
+};
+
+#ifdef DUALIZATION_STATS
+/**
+ * Branches of a node of a search, for the share of the tree explored. A node
+ * that neither enters nor hands over any branch is a dead end.
+ */
+class SearchFrame {
+    Search &s;
+    size_t nodes;
+    size_t handed;
+
+public:
+    SearchFrame(Search &s, size_t branches) : s(s), nodes(s.nodes),
+                                              handed(s.handed) {
+        s.frames.emplace_back(0, branches);
+    }
+
+    ~SearchFrame() {
+        s.frames.pop_back();
+        if (s.nodes == nodes && s.handed == handed && !s.stopped())
+            s.stats.dead_ends++;
+    }
+
+    /*! Starts the next branch*/
+    void next() {
+        s.frames.back().first++;
+    }
+};
+#endif
+
+/**
+ * Runs step(L1, L2, search) over the whole search tree on visitors.size()
+ * threads. Every worker explores its tasks on its own copies of L1 and L2 and
+ * passes the coverages to its own visitor, or counts them if the visitor is
+ * null. The counts of the workers are added to search.count. Returns the
+ * number of nodes.
+ */
+template<class Step>
+size_t parallel_search(PartialBitMatrix &L1, PartialBitMatrix &L2,
+                       Search &search, const vector<CoverageVisitor *> &visitors,
+                       Step step) {
+    WorkStealingPool pool(visitors.size());
+    vector<PartialBitMatrix> left(pool.getThreads(), L1);
+    vector<PartialBitMatrix> right(pool.getThreads(), L2);
+    vector<Search> searches(pool.getThreads(), search);
+    vector<unique_ptr<BranchingStrategy>> strategies;
+
+    for (size_t w = 0; w < pool.getThreads(); w++) {
+        strategies.push_back(search.strategy->clone());
+        searches[w].strategy = strategies[w].get();
+        searches[w].nodes = 0;
+        searches[w].count = 0;
+        SEARCH_STATS(searches[w].stats = SearchStats());
+        searches[w].visitor = visitors[w];
+        searches[w].pool = &pool;
+        searches[w].worker = w;
+    }
+    pool.run(search.path, [&](size_t w, const WorkStealingPool::Task &task) {
+        PartialBitMatrix &A = left[w], &B = right[w];
+        size_t mark1 = A.mark(), mark2 = B.mark();
+        for (size_t k = search.path.size(); k < task.size(); k++) {
+            PartialBitMatrix &L = task[k].first % 2 ? B : A;
+            if (task[k].first < 2) L.select_column(task[k].second);
+            else L.delete_column(task[k].second, false);
+        }
+        searches[w].path = task;
+        step(A, B, searches[w]);
+        A.rollback(mark1);
+        B.rollback(mark2);
+    });
+    size_t nodes = 0;
+    for (auto &worker_search: searches) {
+        nodes += worker_search.nodes;
+        search.count += worker_search.count;
+    }
+    return nodes;
+}
+
+/**
+ * Runs step in parallel with a SaveVisitor per worker and merges what the
+ * workers saved into coverages and found_coverages. The pairs do not depend
+ * on the scheduling; the coverages do up to their order.
+ */
+template<class Step>
+void parallel_collect(PartialBitMatrix &L1, PartialBitMatrix &L2,
+                      Search &search, size_t threads,
+                      CoverageStore &coverages,
+                      set<pair<set<size_t>, set<size_t>>> &found_coverages,
+                      Step step) {
+    vector<CoverageStore> worker_coverages(threads);
+    vector<set<pair<set<size_t>, set<size_t>>>> worker_found(threads);
+    vector<SaveVisitor> savers;
+    vector<CoverageVisitor *> visitors;
+    for (size_t w = 0; w < threads; w++)
+        savers.emplace_back(&worker_coverages[w], &worker_found[w]);
+    for (size_t w = 0; w < threads; w++) visitors.push_back(&savers[w]);
+
+    parallel_search(L1, L2, search, visitors, step);
+    for (size_t w = 0; w < threads; w++) {
+        coverages.merge(worker_coverages[w]);
+        found_coverages.insert(worker_found[w].begin(), worker_found[w].end());
+    }
+}
+
+/*! Row D1 branches on and whether it is a row of L1. One matrix is not empty*/
+inline pair<size_t, bool> D1_branch(PartialBitMatrix &L1, PartialBitMatrix &L2,
+                                    Search &s) {
+    bool L1_empty = L1.getCur_height() == 0;
+    bool L2_empty = L2.getCur_height() == 0;
+    pair<size_t, size_t> res1, res2;
+    if (!L1_empty) res1 = s.strategy->choose(L1);
+    if (!L2_empty) res2 = s.strategy->choose(L2);
+    if (L2_empty || (!L1_empty && res1.second >= res2.second))
+        return {res1.first, true};
+    return {res2.first, false};
+}
+
+inline void D1_step(PartialBitMatrix &L1, PartialBitMatrix &L2, Search &s) {
+    //cout << "FIRST:" << L1 << "SECOND:" << L2 << endl << endl;
+    bool L1_empty, L2_empty, first;
+    size_t row_number;
+
+    if (!s.enter()) return;
+    L1_empty = L1.getCur_height() == 0;
+    L2_empty = L2.getCur_height() == 0;
+    if (L1_empty && L2_empty) {
+        s.report(L1.getSelected_cols(), L2.getSelected_cols());
+        return;
+    }
+    tie(row_number, first) = D1_branch(L1, L2, s);
+    PartialBitMatrix &L = first ? L1 : L2;
+    const PartialBitMatrix &other = first ? L2 : L1;
+    size_t mark = L.mark(), depth = s.path.size();
+    BitsetView branches = L.branch_columns(row_number);
+    SEARCH_STATS(SearchFrame frame(s, branches.count()));
+    for (size_t col: branches) {
+        SEARCH_STATS(frame.next());
+        if (!other.getSelected_cols().in(col) && s.supported(L, col)) {
+            s.path.emplace_back(first ? 0 : 1, col);
+            if (!s.split()) {
+                size_t branch = L.mark();
+                s.select(L, col);
+                D1_step(L1, L2, s);
+                L.rollback(branch);
+            }
+            s.path.pop_back();
+            if (s.stopped()) break;
+        }
+        s.exclude(L, first ? 0 : 1, col);
+    }
+    L.rollback(mark);
+    s.path.resize(depth);
+}
+
+/**
+ * Finds all pairs of disjoint irredundant coverages of L1 and L2, branching
+ * on one row of one of the matrices at a time, and passes them to visitor.
+ * The row comes from strategy and control, if given, may end the search
+ * early. With several threads the visitor is called from all of them, one
+ * call at a time. Returns the number of nodes of the search tree.
+ */
+inline size_t D1_dualization(PartialBitMatrix &L1, PartialBitMatrix &L2,
+                             CoverageVisitor &visitor, BranchingStrategy &strategy,
+                             size_t threads = 1, SearchControl *control = nullptr) {
+    Search search(&strategy, &visitor, control);
+    if (threads <= 1) {
+        D1_step(L1, L2, search);
+        return search.nodes;
+    }
+    SynchronizedVisitor shared(visitor);
+    return parallel_search(L1, L2, search,
+                           vector<CoverageVisitor *>(threads, &shared), D1_step);
+}
+
+/*! D1_dualization branching on the lightest row if weights is set*/
+inline void D1_dualization(PartialBitMatrix &L1, PartialBitMatrix &L2,
+                           CoverageVisitor &visitor, bool weights = false,
+                           size_t threads = 1, SearchControl *control = nullptr) {
+    D1_dualization(L1, L2, visitor, branching_strategy(weights), threads,
+                      control);
+}
+
+inline void D2_step(PartialBitMatrix &L1, PartialBitMatrix &L2, Search &s) {
+    // cout << "FIRST:" << L1 << "SECOND:" << L2 << endl << endl;
+    bool L1_empty, L2_empty;
+    size_t row_number1 = 0, row_number2 = 0;
+    BitsetView one_cols1, one_cols2;
+
+    if (!s.enter()) return;
+    L1_empty = L1.getCur_height() == 0;
+    L2_empty = L2.getCur_height() == 0;
+
+    if (L1_empty && L2_empty) {
+        s.report(L1.getSelected_cols(), L2.getSelected_cols());
+        return;
+    }
+
+    if (!L1_empty) row_number1 = s.strategy->choose(L1).first;
+    if (!L2_empty) row_number2 = s.strategy->choose(L2).first;
+    if (!L1_empty) one_cols1 = L1.branch_columns(row_number1);
+    if (!L2_empty) one_cols2 = L2.branch_columns(row_number2);
+
+    size_t mark1 = L1.mark(), mark2 = L2.mark(), depth = s.path.size();
+    if (!L1_empty && !L2_empty) {
+        SEARCH_STATS(SearchFrame frame(s, one_cols1.count()));
+        for (size_t col1: one_cols1) {
+            SEARCH_STATS(frame.next());
+            if (!L2.getSelected_cols().in(col1) && s.supported(L1, col1)) {
+                size_t depth1 = s.path.size();
+                for (size_t col2: one_cols2) {
+                    if (col1 != col2 && !L1.getSelected_cols().in(col2) &&
+                        s.supported(L2, col2)) {
+                        s.path.emplace_back(0, col1);
+                        s.path.emplace_back(1, col2);
+                        if (!s.split()) {
+                            size_t branch1 = L1.mark(), branch2 = L2.mark();
+                            s.select(L1, col1);
+                            s.select(L2, col2);
+                            D2_step(L1, L2, s);
+                            L1.rollback(branch1);
+                            L2.rollback(branch2);
+                        }
+                        s.path.pop_back();
+                        s.path.pop_back();
+                        if (s.stopped()) break;
+                    }
+                    s.exclude(L2, 1, col2);
+                }
+                L2.rollback(mark2);
+                s.path.resize(depth1);
+                if (s.stopped()) break;
+            }
+            s.exclude(L1, 0, col1);
+        }
+    } else {
+        int first = L1_empty ? 1 : 0;
+        PartialBitMatrix &L = L1_empty ? L2 : L1;
+        const PartialBitMatrix &other = L1_empty ? L1 : L2;
+        BitsetView branches = L1_empty ? one_cols2 : one_cols1;
+        SEARCH_STATS(SearchFrame frame(s, branches.count()));
+        for (size_t col: branches) {
+            SEARCH_STATS(frame.next());
+            if (!other.getSelected_cols().in(col) && s.supported(L, col)) {
+                s.path.emplace_back(first, col);
+                if (!s.split()) {
+                    size_t branch = L.mark();
+                    s.select(L, col);
+                    D2_step(L1, L2, s);
+                    L.rollback(branch);
+                }
+                s.path.pop_back();
+                if (s.stopped()) break;
+            }
+            s.exclude(L, first, col);
+        }
+    }
+    L1.rollback(mark1);
+    L2.rollback(mark2);
+    s.path.resize(depth);
+}
+
+/**
+ * Cache of the results of sub-problems keyed by a 128-bit hash of their
+ * state. The table takes a fixed amount of memory and consists of sets of
+ * WAYS entries. A full set evicts with the clock algorithm: entries found
+ * since the hand last passed them get a second chance.
+ */
+class TranspositionTable {
+    enum { WAYS = 4 };
+
+    struct Bucket {
+        ull hash[WAYS];
+        /*! Second hash of the key, 0 in free entries*/
+        ull check[WAYS];
+        ull value[WAYS];
+        unsigned referenced;
+        unsigned hand;
+    };
+
+    vector<Bucket> buckets;
+    size_t hits, misses, evictions;
+
+public:
+    /*! Creates a table that takes at most bytes of memory*/
+    explicit TranspositionTable(size_t bytes = size_t(64) << 20) : hits(0),
+                                                                    misses(0),
+                                                                    evictions(0) {
+        size_t count = 1;
+        while (2 * count * sizeof(Bucket) <= bytes) count *= 2;
+        buckets.resize(count);
+        clear();
+    }
+
+    bool find(ull hash, ull check, ull &value) {
+        check |= 1;
+        Bucket &bucket = buckets[hash & (buckets.size() - 1)];
+        for (unsigned way = 0; way < WAYS; way++) {
+            if (bucket.check[way] == check && bucket.hash[way] == hash) {
+                bucket.referenced |= 1u << way;
+                value = bucket.value[way];
+                hits++;
+                return true;
+            }
+        }
+        misses++;
+        return false;
+    }
+
+    void store(ull hash, ull check, ull value) {
+        check |= 1;
+        Bucket &bucket = buckets[hash & (buckets.size() - 1)];
+        unsigned way = 0;
+        while (way < WAYS && bucket.check[way] != 0) way++;
+        if (way == WAYS) {
+            while (bucket.referenced & (1u << bucket.hand)) {
+                bucket.referenced &= ~(1u << bucket.hand);
+                bucket.hand = (bucket.hand + 1) % WAYS;
+            }
+            way = bucket.hand;
+            bucket.hand = (bucket.hand + 1) % WAYS;
+            evictions++;
+        }
+        bucket.hash[way] = hash;
+        bucket.check[way] = check;
+        bucket.value[way] = value;
+        bucket.referenced &= ~(1u << way);
+    }
+
+    void clear() {
+        memset(buckets.data(), 0, buckets.size() * sizeof(Bucket));
+        hits = misses = evictions = 0;
+    }
+
+    size_t getCapacity() const {
+        return buckets.size() * WAYS;
+    }
+
+    size_t getHits() const {
+        return hits;
+    }
+
+    size_t getMisses() const {
+        return misses;
+    }
+
+    size_t getEvictions() const {
+        return evictions;
+    }
+};
+
+/**
+ * Checks that no column can be selected in both L1 and L2 any more: the
+ * columns left to L1 are not left to L2. The two matrices are then
+ * independent sub-problems.
+ */
+inline bool D1_independent(const PartialBitMatrix &L1, const PartialBitMatrix &L2) {
+    const ull *cols1 = L1.getAvailable_cols().words(), *cols2 = L2.getAvailable_cols().words();
+    const ull *sel1 = L1.getSelected_cols().words(), *sel2 = L2.getSelected_cols().words();
+    for (size_t w = 0; w < L1.getChunks(); w++) {
+        if (cols1[w] & ~sel2[w] & cols2[w] & ~sel1[w]) return false;
+    }
+    return true;
+}
+
+/**
+ * Counts the coverages D1 completes in L alone, avoiding the columns of other.
+ * Its ends are factors of the pairs counted, so they are not counted as leaves.
+ */
+inline count_t D1_side_count(PartialBitMatrix &L, const PartialBitMatrix &other,
+                             Search &s) {
+    if (!s.enter()) return 0;
+    if (L.getCur_height() == 0) return 1;
+    count_t count = 0;
+    size_t mark = L.mark();
+    BitsetView branches = L.branch_columns(s.strategy->choose(L).first);
+    SEARCH_STATS(SearchFrame frame(s, branches.count()));
+    for (size_t col: branches) {
+        SEARCH_STATS(frame.next());
+        if (!other.getSelected_cols().in(col) && s.supported(L, col)) {
+            size_t branch = L.mark();
+            s.select(L, col);
+            count += D1_side_count(L, other, s);
+            L.rollback(branch);
+            if (s.stopped()) break;
+        }
+        L.delete_column(col, false);
+    }
+    L.rollback(mark);
+    return count;
+}
+
+/**
+ * Counts the pairs found below the current node of D1, or with exists set
+ * returns 1 as soon as one is found. States already counted are looked up in
+ * table if it is given. Once L1 and L2 are independent the count is the
+ * product of the counts of the two matrices, since the branching in one of
+ * them does not depend on the other.
+ */
+inline count_t D1_count_step(PartialBitMatrix &L1, PartialBitMatrix &L2, Search &s,
+                             TranspositionTable *table, bool exists) {
+    enum : ull {
+        HASH_SEED = 0x2545F4914F6CDD1DULL,
+        CHECK_SEED = 0x9E3779B97F4A7C15ULL,
+    };
+    bool first;
+    size_t row_number;
+    ull hash = 0, check = 0, cached;
+    count_t count = 0;
+
+    if (!s.enter()) return 0;
+    if (L1.getCur_height() == 0 && L2.getCur_height() == 0) {
+        SEARCH_STATS(s.leaf(L1.getSelected_cols().count() + L2.getSelected_cols().count()));
+        return 1;
+    }
+    if (table) {
+        hash = L2.state_hash(L1.state_hash(HASH_SEED));
+        check = L2.state_hash(L1.state_hash(CHECK_SEED));
+        if (table->find(hash, check, cached)) return exists ? cached != 0 : cached;
+    }
+    if (!exists && D1_independent(L1, L2)) {
+        count = D1_side_count(L1, L2, s);
+        if (count) count *= D1_side_count(L2, L1, s);
+    } else {
+        tie(row_number, first) = D1_branch(L1, L2, s);
+        PartialBitMatrix &L = first ? L1 : L2;
+        const PartialBitMatrix &other = first ? L2 : L1;
+        size_t mark = L.mark(), depth = s.path.size();
+        BitsetView branches = L.branch_columns(row_number);
+        SEARCH_STATS(SearchFrame frame(s, branches.count()));
+        for (size_t col: branches) {
+            SEARCH_STATS(frame.next());
+            if (!other.getSelected_cols().in(col) && s.supported(L, col)) {
+                s.path.emplace_back(first ? 0 : 1, col);
+                if (!s.split()) {
+                    size_t branch = L.mark();
+                    s.select(L, col);
+                    count += D1_count_step(L1, L2, s, table, exists);
+                    L.rollback(branch);
+                }
+                s.path.pop_back();
+                if ((exists && count) || s.stopped()) break;
+            }
+            s.exclude(L, first ? 0 : 1, col);
+        }
+        L.rollback(mark);
+        s.path.resize(depth);
+        if (exists && count) return 1;
+        if (s.stopped()) return count;
+    }
+    if (table && !s.stopped() && count <= count_t(ULLONG_MAX))
+        table->store(hash, check, (ull) count);
+    return count;
+}
+
+/*! D1_count_step as a task of parallel_search*/
+inline void D1_count_task(PartialBitMatrix &L1, PartialBitMatrix &L2, Search &s) {
+    s.count += D1_count_step(L1, L2, s, nullptr, false);
+}
+
+/**
+ * Counts the pairs D1_dualization finds without building them. Different
+ * orders of selection often lead to the same state; with a table the count of
+ * such a state is computed once. The strategy should be deterministic, since
+ * a cached count comes from the tree of the first visit. control may stop
+ * the count early, its result limit aside. With several threads every worker
+ * counts its own sub-trees and the table is not used.
+ */
+inline count_t D1_count(PartialBitMatrix &L1, PartialBitMatrix &L2,
+                        BranchingStrategy &strategy, TranspositionTable *table = nullptr,
+                        SearchControl *control = nullptr, size_t threads = 1) {
+    Search search(&strategy, nullptr, control);
+    if (threads <= 1) return D1_count_step(L1, L2, search, table, false);
+    parallel_search(L1, L2, search, vector<CoverageVisitor *>(threads, nullptr),
+                    D1_count_task);
+    return search.count;
+}
+
+inline count_t D1_count(PartialBitMatrix &L1, PartialBitMatrix &L2, bool weights = false,
+                        TranspositionTable *table = nullptr,
+                        SearchControl *control = nullptr, size_t threads = 1) {
+    return D1_count(L1, L2, branching_strategy(weights), table, control, threads);
+}
+
+/*! Checks whether L1 and L2 have a pair of disjoint irredundant coverages*/
+inline bool D1_exists(PartialBitMatrix &L1, PartialBitMatrix &L2,
+                      BranchingStrategy &strategy, TranspositionTable *table = nullptr,
+                      SearchControl *control = nullptr) {
+    Search search(&strategy, nullptr, control);
+    return D1_count_step(L1, L2, search, table, true) != 0;
+}
+
+inline bool D1_exists(PartialBitMatrix &L1, PartialBitMatrix &L2, bool weights = false,
+                      TranspositionTable *table = nullptr,
+                      SearchControl *control = nullptr) {
+    return D1_exists(L1, L2, branching_strategy(weights), table, control);
+}
+
+/**
+ * Finds all pairs of disjoint irredundant coverages of L1 and L2, branching
+ * on one row of each matrix at a time, and passes them to visitor. The rows
+ * come from strategy and control, if given, may end the search early.
+ * Returns the number of nodes of the search tree.
+ */
+inline size_t D2_dualization(PartialBitMatrix &L1, PartialBitMatrix &L2,
+                             CoverageVisitor &visitor, BranchingStrategy &strategy,
+                             size_t threads = 1, SearchControl *control = nullptr) {
+    Search search(&strategy, &visitor, control);
+    if (threads <= 1) {
+        D2_step(L1, L2, search);
+        return search.nodes;
+    }
+    SynchronizedVisitor shared(visitor);
+    return parallel_search(L1, L2, search,
+                           vector<CoverageVisitor *>(threads, &shared), D2_step);
+}
+
+/*! D2_dualization branching on the lightest row if weights is set*/
+inline void D2_dualization(PartialBitMatrix &L1, PartialBitMatrix &L2,
+                           CoverageVisitor &visitor, bool weights = false,
+                           size_t threads = 1, SearchControl *control = nullptr) {
+    D2_dualization(L1, L2, visitor, branching_strategy(weights), threads,
+                      control);
+}
+
+inline void dualization_step(PartialBitMatrix &L1, Search &s) {
+    //cout << "FIRST:" << L1 << endl << endl;
+    bool L1_empty;
+    size_t row_number;
+
+    if (!s.enter()) return;
+    L1_empty = L1.getCur_height() == 0;
+    if (L1_empty) {
+        s.report(L1.getSelected_cols());
+        return;
+    }
+    row_number = s.strategy->choose(L1).first;
+    size_t mark = L1.mark(), depth = s.path.size();
+    BitsetView branches = L1.branch_columns(row_number);
+    SEARCH_STATS(SearchFrame frame(s, branches.count()));
+    for (size_t col: branches) {
+        SEARCH_STATS(frame.next());
+        if (s.supported(L1, col)) {
+            s.path.emplace_back(0, col);
+            if (!s.split()) {
+                size_t branch = L1.mark();
+                s.select(L1, col);
+                dualization_step(L1, s);
+                L1.rollback(branch);
+            }
+            s.path.pop_back();
+            if (s.stopped()) break;
+        }
+        s.exclude(L1, 0, col);
+    }
+    L1.rollback(mark);
+    s.path.resize(depth);
+}
+
+inline void dualization_step(PartialBitMatrix &A, PartialBitMatrix &, Search &s) {
+    dualization_step(A, s);
+}
+
+/**
+ * Finds all irredundant coverages of L1, branching on the rows strategy
+ * chooses, and passes each of them once to visitor. control, if given, may end the search
+ * early. With several threads the visitor is called from all of them, one
+ * call at a time. Returns the number of nodes of the search tree.
+ */
+inline size_t dualization(PartialBitMatrix &L1, CoverageVisitor &visitor,
+                          BranchingStrategy &strategy, size_t threads = 1,
+                          SearchControl *control = nullptr) {
+    Search search(&strategy, &visitor, control);
+    if (threads <= 1) {
+        dualization_step(L1, search);
+        return search.nodes;
+    }
+    SynchronizedVisitor shared(visitor);
+    PartialBitMatrix unused;
+    void (*step)(PartialBitMatrix &, PartialBitMatrix &, Search &) = dualization_step;
+    return parallel_search(L1, unused, search,
+                           vector<CoverageVisitor *>(threads, &shared), step);
+}
+
+/*! dualization branching on the lightest row if weights is set*/
+inline void dualization(PartialBitMatrix &L1, CoverageVisitor &visitor,
+                        bool weights = false, size_t threads = 1,
+                        SearchControl *control = nullptr) {
+    dualization(L1, visitor, branching_strategy(weights), threads, control);
+}
+
+/**
+ * Counts the coverages dualization finds without building them. Every thread
+ * keeps its own counter. Every coverage is counted once.
+ */
+inline count_t dualization_count(PartialBitMatrix &L1, BranchingStrategy &strategy,
+                                 size_t threads = 1, SearchControl *control = nullptr) {
+    Search search(&strategy, nullptr, control);
+    if (threads <= 1) {
+        dualization_step(L1, search);
+        return search.count;
+    }
+    PartialBitMatrix unused;
+    void (*step)(PartialBitMatrix &, PartialBitMatrix &, Search &) = dualization_step;
+    parallel_search(L1, unused, search, vector<CoverageVisitor *>(threads, nullptr),
+                    step);
+    return search.count;
+}
+
+inline count_t dualization_count(PartialBitMatrix &L1, bool weights = false,
+                                 size_t threads = 1, SearchControl *control = nullptr) {
+    return dualization_count(L1, branching_strategy(weights), threads, control);
+}
+
+/*! Rows and columns of one connected component of a matrix*/
+struct MatrixComponent {
+    vector<size_t> rows;
+    vector<size_t> cols;
+};
+
+/**
+ * Splits the available rows and columns of A into the connected components
+ * of the graph joining row i and column j if A has 1 at (i, j). No two
+ * components share a row or a column, so every irredundant coverage of A is
+ * the union of one irredundant coverage of every component. A row without
+ * available columns is a component of its own. Components are ordered by
+ * their first row.
+ */
+inline vector<MatrixComponent> find_components(const PartialBitMatrix &A) {
+    vector<size_t> parent(A.getHeight());
+    for (size_t i = 0; i < parent.size(); i++) parent[i] = i;
+    auto find = [&parent](size_t i) {
+        while (parent[i] != i) i = parent[i] = parent[parent[i]];
+        return i;
+    };
+
+    const ull *rows = A.getAvailable_rows().words();
+    vector<size_t> first_row(A.getWidth(), SIZE_MAX);
+    for (size_t col: A.getAvailable_cols()) {
+        const ull *one_rows = A.column(col);
+        for (size_t w = 0; w < A.getColumn_chunks(); w++) {
+            ull bits = one_rows[w] & rows[w];
+            while (bits) {
+                size_t i = w * CHUNK_SIZE + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                if (first_row[col] == SIZE_MAX) {
+                    first_row[col] = i;
+                    continue;
+                }
+                size_t a = find(first_row[col]), b = find(i);
+                if (a != b) parent[max(a, b)] = min(a, b);
+            }
+        }
+    }
+
+    vector<MatrixComponent> components;
+    vector<size_t> index(A.getHeight(), SIZE_MAX);
+    for (size_t i: A.getAvailable_rows()) {
+        size_t root = find(i);
+        if (index[root] == SIZE_MAX) {
+            index[root] = components.size();
+            components.emplace_back();
+        }
+        components[index[root]].rows.push_back(i);
+    }
+    for (size_t col: A.getAvailable_cols()) {
+        if (first_row[col] != SIZE_MAX)
+            components[index[find(first_row[col])]].cols.push_back(col);
+    }
+    return components;
+}
+
+/**
+ * Cartesian product of the coverages of the components of a matrix, produced
+ * one union at a time by next(). The coverages of every part are stored with
+ * the columns of the whole matrix, and the unions of the first k chosen
+ * coverages are kept, so a step of next() only redoes the parts that changed.
+ */
+class ComponentProduct {
+    size_t width;
+    size_t chunks;
+    vector<CoverageStore> parts;
+    vector<size_t> digits;
+    vector<ull> prefix;
+    bool started;
+    bool done;
+
+    /*! Recomputes the unions from part k on*/
+    void fill(size_t k) {
+        for (; k < parts.size(); k++) {
+            const ull *part = parts[k][digits[k]].words();
+            const ull *prev = prefix.data() + k * chunks;
+            ull *dst = prefix.data() + (k + 1) * chunks;
+            for (size_t w = 0; w < chunks; w++) dst[w] = prev[w] | part[w];
+        }
+    }
+
+public:
+    explicit ComponentProduct(size_t width) : width(width),
+                                              chunks((width + CHUNK_SIZE - 1) / CHUNK_SIZE),
+                                              started(false), done(false) {}
+
+    /*! Adds a part, which has to be filled before next() is called*/
+    CoverageStore &add_part() {
+        parts.emplace_back(false);
+        return parts.back();
+    }
+
+    /*! Number of unions, the product of the sizes of the parts*/
+    count_t size() const {
+        count_t total = 1;
+        for (auto &part: parts) total *= part.size();
+        return total;
+    }
+
+    /*! Sets coverage to the next union. Returns false after the last one*/
+    bool next(BitsetView &coverage) {
+        if (done) return false;
+        if (!started) {
+            started = true;
+            for (auto &part: parts) {
+                if (part.empty()) {
+                    done = true;
+                    return false;
+                }
+            }
+            digits.assign(parts.size(), 0);
+            prefix.assign((parts.size() + 1) * chunks, 0);
+            fill(0);
+        } else {
+            size_t k = parts.size();
+            while (k > 0 && digits[k - 1] + 1 == parts[k - 1].size()) {
+                digits[k - 1] = 0;
+                k--;
+            }
+            if (k == 0) {
+                done = true;
+                return false;
+            }
+            digits[k - 1]++;
+            fill(k - 1);
+        }
+        coverage = BitsetView(prefix.data() + parts.size() * chunks, width);
+        return true;
+    }
+};
+
+/*! Adds the coverages of a submatrix to a store with the columns of the whole matrix*/
+class ComponentVisitor : public CoverageVisitor {
+    CoverageStore &part;
+    const vector<size_t> &cols;
+    vector<ull> words;
+    size_t width;
+
+public:
+    ComponentVisitor(CoverageStore &part, const vector<size_t> &cols,
+                     size_t width) : part(part), cols(cols),
+                                     words((width + CHUNK_SIZE - 1) / CHUNK_SIZE),
+                                     width(width) {}
+
+    void visit(const BitsetView &coverage) override {
+        fill(words.begin(), words.end(), 0);
+        for (size_t col: coverage)
+            words[cols[col] / CHUNK_SIZE] |= 1ULL << (cols[col] % CHUNK_SIZE);
+        part.insert(BitsetView(words.data(), width));
+    }
+
+    void visit(const BitsetView &, const BitsetView &) override {}
+};
+
+/**
+ * Dualizes every component of L1 on its own into product. Returns the number
+ * of nodes of all the searches.
+ */
+inline size_t component_search(PartialBitMatrix &L1, ComponentProduct &product,
+                               BranchingStrategy &strategy, size_t threads,
+                               SearchControl *control) {
+    if (L1.getSelected_cols().begin() != L1.getSelected_cols().end()) {
+        cerr << "Components of a matrix with selected columns" << endl;
+        throw logic_error("");
+    }
+    size_t nodes = 0;
+    for (auto &component: find_components(L1)) {
+        CoverageStore &part = product.add_part();
+        if (component.cols.empty()) break;
+        PartialBitMatrix sub(L1, component.rows, component.cols);
+        ComponentVisitor collector(part, component.cols, L1.getWidth());
+        Search search(&strategy, &collector, control);
+        search.limited = false;
+        if (threads <= 1) {
+            dualization_step(sub, search);
+            nodes += search.nodes;
+        } else {
+            SynchronizedVisitor shared(collector);
+            PartialBitMatrix unused;
+            void (*step)(PartialBitMatrix &, PartialBitMatrix &, Search &) = dualization_step;
+            nodes += parallel_search(sub, unused, search,
+                                     vector<CoverageVisitor *>(threads, &shared), step);
+        }
+        if (part.empty() || (control && control->stopped())) break;
+    }
+    return nodes;
+}
+
+/**
+ * dualization that finds the coverages of the connected components of L1
+ * separately and passes on their unions. The search tree of a matrix made
+ * of blocks is the product of the trees of the blocks, while here it is
+ * their sum. Only the product itself is as large as before, and it is built
+ * one union at a time. The components are searched one after another, each
+ * on all the threads. L1 must not have selected columns. Returns the number
+ * of nodes.
+ */
+inline size_t component_dualization(PartialBitMatrix &L1, CoverageVisitor &visitor,
+                                    BranchingStrategy &strategy, size_t threads = 1,
+                                    SearchControl *control = nullptr) {
+    ComponentProduct product(L1.getWidth());
+    size_t nodes = component_search(L1, product, strategy, threads, control);
+    if (control && control->stopped()) return nodes;
+    BitsetView coverage;
+    for (size_t k = 1; product.next(coverage); k++) {
+        if (control && (control->check(k) || !control->admit())) break;
+        visitor.visit(coverage);
+    }
+    return nodes;
+}
+
+inline void component_dualization(PartialBitMatrix &L1, CoverageVisitor &visitor,
+                                  bool weights = false, size_t threads = 1,
+                                  SearchControl *control = nullptr) {
+    component_dualization(L1, visitor, branching_strategy(weights), threads, control);
+}
+
+/**
+ * dualization_count over the connected components of L1: the product of the
+ * numbers of coverages of the components. control may stop the count early,
+ * its result limit aside.
+ */
+inline count_t component_count(PartialBitMatrix &L1, BranchingStrategy &strategy,
+                               size_t threads = 1, SearchControl *control = nullptr) {
+    if (L1.getSelected_cols().begin() != L1.getSelected_cols().end()) {
+        cerr << "Components of a matrix with selected columns" << endl;
+        throw logic_error("");
+    }
+    count_t total = 1;
+    for (auto &component: find_components(L1)) {
+        if (component.cols.empty()) return 0;
+        PartialBitMatrix sub(L1, component.rows, component.cols);
+        Search search(&strategy, nullptr, control);
+        search.limited = false;
+        if (threads <= 1) {
+            dualization_step(sub, search);
+        } else {
+            PartialBitMatrix unused;
+            void (*step)(PartialBitMatrix &, PartialBitMatrix &, Search &) = dualization_step;
+            parallel_search(sub, unused, search,
+                            vector<CoverageVisitor *>(threads, nullptr), step);
+        }
+        total *= search.count;
+        if (total == 0 || (control && control->stopped())) break;
+    }
+    return total;
+}
+
+inline count_t component_count(PartialBitMatrix &L1, bool weights = false,
+                               size_t threads = 1, SearchControl *control = nullptr) {
+    return component_count(L1, branching_strategy(weights), threads, control);
+}
+
+/**
+ * Irredundant coverages of L with the rows of added appended, computed from
+ * coverages, all irredundant coverages of L, by Berge multiplication. The
+ * rows are added one at a time. A coverage meeting the new row stays
+ * irredundant. A coverage T missing it gives way to T + {v} for the columns
+ * v of the row such that every column of T keeps a row that no other column
+ * of T + {v} covers; the other extensions contain a kept coverage, and no
+ * other set can be redundant, so the coverages are never compared with each
+ * other. A kept coverage costs one test against the row, an extended one a
+ * pass over the columns of T in the transposed matrix and over the rows it
+ * alone covers. An L without rows has the single empty coverage; with an
+ * empty row it has none.
+ */
+inline CoverageStore extend_coverages(const BitMatrix &L, const CoverageStore &coverages,
+                                      const BitMatrix &added) {
+    size_t width = L.getWidth(), chunks = L.getChunks(), column_chunks = L.getColumn_chunks();
+    if (added.getWidth() != width || (!coverages.empty() && coverages.getWidth() != width)) {
+        cerr << "Matrices and coverages should be of equal width" << endl;
+        throw length_error("");
+    }
+    CoverageStore current;
+    current.merge(coverages);
+    vector<ull> ones(column_chunks), twos(column_chunks), critical(chunks), forbidden(chunks);
+    vector<ull> extended(chunks);
+    vector<size_t> columns;
+
+    for (size_t k = 0; k < added.getHeight(); k++) {
+        const ull *row = added.row(k);
+        CoverageStore next;
+        for (BitsetView coverage: current) {
+            const ull *T = coverage.words();
+            if (!is_disjoint(T, row, chunks)) {
+                next.insert(coverage);
+                continue;
+            }
+            // Rows of L covered by exactly one column of T
+            columns.assign(coverage.begin(), coverage.end());
+            fill(ones.begin(), ones.end(), 0);
+            fill(twos.begin(), twos.end(), 0);
+            for (size_t col: columns) {
+                const ull *c = L.column(col);
+                for (size_t w = 0; w < column_chunks; w++) {
+                    twos[w] |= ones[w] & c[w];
+                    ones[w] |= c[w];
+                }
+            }
+            // A column v may join T unless some column of T has all of its
+            // own rows in v
+            fill(forbidden.begin(), forbidden.end(), 0);
+            for (size_t col: columns) {
+                fill(critical.begin(), critical.end(), ~0ULL);
+                bool own = false;
+                const ull *c = L.column(col);
+                for (size_t w = 0; w < column_chunks; w++) {
+                    for (ull bits = c[w] & ones[w] & ~twos[w]; bits; bits &= bits - 1) {
+                        const ull *r = L.row(w * CHUNK_SIZE + __builtin_ctzll(bits));
+                        for (size_t x = 0; x < chunks; x++) critical[x] &= r[x];
+                        own = true;
+                    }
+                }
+                for (size_t j = 0; j < k; j++) {
+                    const ull *r = added.row(j);
+                    size_t hits = 0;
+                    for (size_t x = 0; x < chunks && hits < 2; x++)
+                        hits += __builtin_popcountll(r[x] & T[x]);
+                    if (hits != 1 || !((r[col / CHUNK_SIZE] >> (col % CHUNK_SIZE)) & 1ULL))
+                        continue;
+                    for (size_t x = 0; x < chunks; x++) critical[x] &= r[x];
+                    own = true;
+                }
+                if (!own) {
+                    cerr << "Coverage is not irredundant: column " << col
+                         << " covers no row alone" << endl;
+                    throw invalid_argument("");
+                }
+                for (size_t x = 0; x < chunks; x++) forbidden[x] |= critical[x];
+            }
+            for (size_t x = 0; x < chunks; x++) {
+                for (ull bits = row[x] & ~forbidden[x]; bits; bits &= bits - 1) {
+                    copy(T, T + chunks, extended.begin());
+                    extended[x] |= bits & (0 - bits);
+                    next.insert(BitsetView(extended.data(), width));
+                }
+            }
+        }
+        current = move(next);
+    }
+    return current;
+}
+
+/**
+ * Set trie over a collection of coverages that finds the coverages disjoint
+ * from a given set of columns. A coverage is a path of its columns from the
+ * root, the most frequent columns first, so a query cuts off every subtree
+ * whose path meets the set as high in the trie as possible. Coverages are
+ * numbered in the order of the collection.
+ */
+class DisjointIndex {
+    enum : size_t { NONE = SIZE_MAX };
+
+    struct Node {
+        size_t column;
+        /*! Position of column in the order of the paths*/
+        size_t rank;
+        size_t child_begin, child_end;
+        /*! Number of the coverage ending here, NONE if there is none*/
+        size_t cover;
+        /*! Smallest number of a coverage in the subtree*/
+        size_t min_cover;
+        /*! Number of coverages in the subtree*/
+        size_t covers;
+    };
+
+    vector<Node> nodes;
+    const CoverageStore &covers;
+    vector<size_t> rank;
+    vector<size_t> stack;
+
+    /*! Adds the children of node for the paths [lo, hi) sharing depth columns*/
+    void build(size_t node, vector<pair<vector<size_t>, size_t>> &paths,
+               size_t lo, size_t hi, size_t depth, const vector<size_t> &columns) {
+        if (lo < hi && paths[lo].first.size() == depth) {
+            nodes[node].cover = paths[lo].second;
+            lo++;
+        }
+        nodes[node].child_begin = nodes.size();
+        for (size_t i = lo; i < hi;) {
+            size_t j = i;
+            while (j < hi && paths[j].first[depth] == paths[i].first[depth]) j++;
+            size_t r = paths[i].first[depth];
+            nodes.push_back({columns[r], r, 0, 0, NONE, NONE, 0});
+            i = j;
+        }
+        nodes[node].child_end = nodes.size();
+        size_t child = nodes[node].child_begin;
+        for (size_t i = lo; i < hi; child++) {
+            size_t j = i;
+            while (j < hi && paths[j].first[depth] == paths[i].first[depth]) j++;
+            build(child, paths, i, j, depth + 1, columns);
+            i = j;
         }
-        if (!L2_empty) {
-            row_number2 = *L2.getAvailable_rows().begin();
-            for (size_t col: L2.getAvailable_cols()) {
-                if (L2.at(row_number2, col)) one_cols2.insert(col);
+        size_t min_cover = nodes[node].cover;
+        size_t count = nodes[node].cover != NONE;
+        for (child = nodes[node].child_begin; child < nodes[node].child_end; child++) {
+            min_cover = min(min_cover, nodes[child].min_cover);
+            count += nodes[child].covers;
+        }
+        nodes[node].min_cover = min_cover;
+        nodes[node].covers = count;
+    }
+
+public:
+    explicit DisjointIndex(const CoverageStore &coverages) : covers(coverages) {
+        size_t width = covers.getWidth();
+        vector<size_t> frequency(width, 0);
+        for (BitsetView cover: covers)
+            for (size_t col: cover) frequency[col]++;
+        vector<size_t> columns(width);
+        rank.resize(width);
+        for (size_t col = 0; col < width; col++) columns[col] = col;
+        stable_sort(columns.begin(), columns.end(), [&](size_t a, size_t b) {
+            return frequency[a] > frequency[b];
+        });
+        for (size_t r = 0; r < width; r++) rank[columns[r]] = r;
+
+        vector<pair<vector<size_t>, size_t>> paths(covers.size());
+        for (size_t k = 0; k < covers.size(); k++) {
+            for (size_t col: covers[k]) paths[k].first.push_back(rank[col]);
+            sort(paths[k].first.begin(), paths[k].first.end());
+            paths[k].second = k;
+        }
+        sort(paths.begin(), paths.end());
+        nodes.push_back({NONE, 0, 0, 0, NONE, NONE, 0});
+        build(0, paths, 0, paths.size(), 0, columns);
+    }
+
+    size_t size() const {
+        return covers.size();
+    }
+
+    BitsetView operator[](size_t k) const {
+        return covers[k];
+    }
+
+    /**
+     * Appends to found the numbers of the coverages disjoint from columns, in
+     * no particular order. With first set only the smallest such number is
+     * appended.
+     */
+    void disjoint(const BitsetView &columns, vector<size_t> &found, bool first = false) {
+        size_t best = NONE;
+        stack.assign(1, 0);
+        while (!stack.empty()) {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+            if (first && node.min_cover >= best) continue;
+            if (node.cover != NONE) {
+                if (first) best = min(best, node.cover);
+                else found.push_back(node.cover);
+            }
+            for (size_t child = node.child_begin; child < node.child_end; child++) {
+                size_t col = nodes[child].column;
+                if (col < columns.size() && columns.in(col)) continue;
+                if (first && nodes[child].min_cover >= best) continue;
+                stack.push_back(child);
             }
         }
+        if (first && best != NONE) found.push_back(best);
     }
-    if (!L1_empty && !L2_empty) {
-        for (size_t col1: one_cols1) {
-            if ((L2.getSelected_cols().find(col1) !=
-                 L2.getSelected_cols().end()) ||
-                !check_support_rows(L1, supporting_rows1, col1))
-                continue;
-            for (size_t col2: one_cols2) {
-                if ((col1 == col2) || (L1.getSelected_cols().find(col2) !=
-                                       L1.getSelected_cols().end()))
-                    continue;
-                if (check_support_rows(L2, supporting_rows2, col2)) {
-                    supporting_rows1_new = update_support_rows(L1,
-                                                               supporting_rows1,
-                                                               col1);
-                    supporting_rows2_new = update_support_rows(L2,
-                                                               supporting_rows2,
-                                                               col2);
-                    L1_new = L1;
-                    L2_new = L2;
-                    for (size_t i = 0; i < L1.getHeight(); i++) {
-                        if (L1.at(i, col1)) L1_new.delete_row(i);
-                    }
-                    for (size_t i = 0; i < L2.getHeight(); i++) {
-                        if (L2.at(i, col2)) L2_new.delete_row(i);
-                    }
-                    L1_new.delete_column(col1);
-                    L1_new.update_matrix();
-                    L2_new.delete_column(col2);
-                    L2_new.update_matrix();
-                    D2_dualization(L1_new, L2_new, supporting_rows1_new,
-                                   supporting_rows2_new, weights, save,
-                                   found_coverages);
-                }
+
+    /**
+     * Number of coverages disjoint from columns. A subtree below the highest
+     * ranked of the columns is disjoint from them as a whole and is counted
+     * without a walk. stack is scratch space, so several threads may count
+     * at once.
+     */
+    size_t count_disjoint(const BitsetView &columns, vector<size_t> &stack) const {
+        size_t top = 0, count = 0;
+        bool any = false;
+        for (size_t col: columns) {
+            if (col >= rank.size()) break;
+            top = max(top, rank[col]);
+            any = true;
+        }
+        if (!any) return covers.size();
+        stack.assign(1, 0);
+        while (!stack.empty()) {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+            if (node.cover != NONE) count++;
+            for (size_t child = node.child_begin; child < node.child_end; child++) {
+                if (nodes[child].rank > top) count += nodes[child].covers;
+                else if (!columns.in(nodes[child].column)) stack.push_back(child);
             }
         }
-    } else {
-        if (!L1_empty) {
-            for (size_t col1: one_cols1) {
-                if (L2.getSelected_cols().find(col1) !=
-                    L2.getSelected_cols().end())
-                    continue;
-                if (check_support_rows(L1, supporting_rows1, col1)) {
-                    supporting_rows1_new = update_support_rows(L1,
-                                                               supporting_rows1,
-                                                               col1);
-                    L1_new = L1;
-                    for (size_t i = 0; i < L1.getHeight(); i++) {
-                        if (L1.at(i, col1)) L1_new.delete_row(i);
+        return count;
+    }
+
+    /*! Checks that some coverage is disjoint from columns*/
+    bool has_disjoint(const BitsetView &columns, vector<size_t> &stack) const {
+        stack.assign(1, 0);
+        while (!stack.empty()) {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+            if (node.cover != NONE) return true;
+            for (size_t child = node.child_begin; child < node.child_end; child++) {
+                size_t col = nodes[child].column;
+                if (col >= columns.size() || !columns.in(col)) stack.push_back(child);
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * Passes to visitor the pairs of disjoint coverages from cov1 and cov2, in the
+ * order of cov1 and then of cov2. With exist set only the first pair of every
+ * coverage from cov1 is passed. The coverages of cov2 are indexed first, so
+ * the time depends on the number of disjoint pairs rather than on
+ * |cov1| * |cov2|. control, if given, may end the join early.
+ */
+inline void combine(CoverageStore &cov1, CoverageStore &cov2, CoverageVisitor &visitor,
+                    bool exist, SearchControl *control = nullptr) {
+    DisjointIndex index(cov2);
+    vector<size_t> found;
+    size_t queries = 0;
+    for (BitsetView set1: cov1) {
+        if (control && control->check(++queries)) return;
+        found.clear();
+        index.disjoint(set1, found, exist);
+        sort(found.begin(), found.end());
+        for (size_t k: found) {
+            if (set1.size() != index[k].size()) {
+                cerr << "Sets should be of equal size" << endl;
+            }
+            if (control && !control->admit()) return;
+            visitor.visit(set1, index[k]);
+        }
+    }
+}
+
+/**
+ * Counts the pairs combine would pass, or with exist set the coverages of
+ * cov1 having a disjoint partner, without building any of them. cov1 is
+ * shared between threads, each with its own counter. control may stop the
+ * count early, its result limit aside.
+ */
+inline count_t combine_count(CoverageStore &cov1, CoverageStore &cov2, bool exist,
+                             size_t threads = 1, SearchControl *control = nullptr) {
+    enum { BLOCK = 256 };
+    DisjointIndex index(cov2);
+    size_t blocks = (cov1.size() + BLOCK - 1) / BLOCK;
+    threads = max<size_t>(threads, 1);
+    atomic<size_t> next_block(0);
+    vector<count_t> counts(threads * (CACHE_LINE / sizeof(count_t)), 0);
+
+    auto work = [&](size_t t) {
+        vector<size_t> stack;
+        count_t &count = counts[t * (CACHE_LINE / sizeof(count_t))];
+        size_t queries = 0;
+        for (size_t b; (b = next_block++) < blocks;) {
+            for (size_t i = b * BLOCK; i < min(cov1.size(), (b + 1) * BLOCK); i++) {
+                if (control && control->check(++queries)) return;
+                if (exist) count += index.has_disjoint(cov1[i], stack);
+                else count += index.count_disjoint(cov1[i], stack);
+            }
+        }
+    };
+
+    vector<thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(work, t);
+    work(0);
+    for (auto &worker: workers) worker.join();
+    count_t total = 0;
+    for (size_t t = 0; t < threads; t++) total += counts[t * (CACHE_LINE / sizeof(count_t))];
+    return total;
+}
+
+/**
+ * Brute-force version of combine for the cases where most pairs are disjoint
+ * and an index does not help. The packed coverages of cov1 and cov2 are
+ * compared in tiles: a block of cov1 against a run of cov2 small enough to
+ * stay in the L1 cache. Blocks of cov1 are shared between visitors.size()
+ * threads, and thread t passes its pairs to visitors[t], which may be null to
+ * only count them. Within a thread the pairs of a coverage from cov1 come in
+ * the order of cov2; with exist set only the first one is passed. control, if
+ * given, admits every pair and is checked at the start of every block and
+ * tile, so the join may be capped, timed out or cancelled. Returns the number
+ * of pairs passed.
+ */
+inline size_t combine_blocked(CoverageStore &cov1, CoverageStore &cov2,
+                              const vector<CoverageVisitor *> &visitors, bool exist,
+                              SearchControl *control = nullptr) {
+    enum { BLOCK_ROWS = 64, TILE_BYTES = 16384 };
+    if (cov1.size() && cov2.size() && cov1.getWidth() != cov2.getWidth()) {
+        cerr << "Sets should be of equal size" << endl;
+        throw length_error("");
+    }
+    size_t chunks = cov1.getChunks();
+    size_t tile = max<size_t>(1, TILE_BYTES / (max<size_t>(chunks, 1) * sizeof(ull)));
+    size_t blocks = (cov1.size() + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    size_t threads = max<size_t>(visitors.size(), 1);
+    atomic<size_t> next_block(0);
+    vector<size_t> counts(threads * (CACHE_LINE / sizeof(size_t)), 0);
+
+    auto work = [&](size_t t) {
+        CoverageVisitor *visitor = t < visitors.size() ? visitors[t] : nullptr;
+        size_t &count = counts[t * (CACHE_LINE / sizeof(size_t))];
+        bool done[BLOCK_ROWS];
+        size_t checks = 0;
+        dispatch_words(chunks, [&](auto C) {
+            for (size_t b; (b = next_block++) < blocks;) {
+                if (control && control->check(++checks)) return;
+                size_t lo = b * BLOCK_ROWS, hi = min(cov1.size(), lo + BLOCK_ROWS);
+                fill(done, done + BLOCK_ROWS, false);
+                for (size_t tlo = 0; tlo < cov2.size(); tlo += tile) {
+                    if (control && control->check(++checks)) return;
+                    size_t thi = min(cov2.size(), tlo + tile);
+                    for (size_t i = lo; i < hi; i++) {
+                        if (done[i - lo]) continue;
+                        const ull *a = cov1.at(i);
+                        for (size_t j = tlo; j < thi; j++) {
+                            if (!is_disjoint<decltype(C)::value>(a, cov2.at(j), chunks))
+                                continue;
+                            if (control && !control->admit()) return;
+                            count++;
+                            if (visitor) visitor->visit(cov1[i], cov2[j]);
+                            if (exist) {
+                                done[i - lo] = true;
+                                break;
+                            }
+                        }
                     }
-                    L1_new.delete_column(col1);
-                    L1_new.update_matrix();
-                    D2_dualization(L1_new, L2, supporting_rows1_new,
-                                   supporting_rows2, weights, save,
-                                   found_coverages);
                 }
             }
+        });
+    };
+
+    vector<thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(work, t);
+    work(0);
+    for (auto &worker: workers) worker.join();
+    size_t total = 0;
+    for (size_t t = 0; t < threads; t++) total += counts[t * (CACHE_LINE / sizeof(size_t))];
+    return total;
+}
+
+/*! combine_blocked on several threads passing all pairs to one visitor*/
+inline size_t combine_blocked(CoverageStore &cov1, CoverageStore &cov2,
+                              CoverageVisitor &visitor, bool exist, size_t threads = 1,
+                              SearchControl *control = nullptr) {
+    if (threads <= 1) return combine_blocked(cov1, cov2, {&visitor}, exist, control);
+    SynchronizedVisitor shared(visitor);
+    return combine_blocked(cov1, cov2, vector<CoverageVisitor *>(threads, &shared),
+                           exist, control);
+}
+
+/**
+ * Context of one dualization job: the configuration of the engines, the
+ * number of pairs printed and the stores the saved results go to. Nothing
+ * else in this header is mutable outside of the objects a caller creates, so
+ * jobs with a Dualizer each may run at once from any threads. A Dualizer
+ * serves one job at a time.
+ */
+class Dualizer {
+    unique_ptr<BranchingStrategy> strategy;
+    /*! Whether combine only looks for one second coverage of each first one*/
+    bool exist;
+    size_t threads;
+    /*! Number of pairs printed by D1_dualization, D2_dualization and combine*/
+    size_t count;
+    CoverageStore coverages;
+    set<pair<set<size_t>, set<size_t>>> found_coverages;
+
+    /*! Prints and counts the pairs of one of the engines or saves them*/
+    template<class Run, class Step>
+    void pairs(PartialBitMatrix &L1, PartialBitMatrix &L2,
+               set<pair<set<size_t>, set<size_t>>> *found, Run run, Step step) {
+        PrintVisitor printer(&count);
+        if (threads <= 1) {
+            SaveVisitor saver(&coverages, found);
+            run(L1, L2, found ? (CoverageVisitor &) saver : printer, *strategy);
+            return;
+        }
+        Search search(strategy.get(), nullptr);
+        set<pair<set<size_t>, set<size_t>>> result;
+        parallel_collect(L1, L2, search, threads, coverages, found ? *found : result, step);
+        if (!found) {
+            count += result.size();
+            print_results(result);
+        }
+    }
+
+public:
+    /*! Branches on the lightest row if weights is set, else on the first one*/
+    explicit Dualizer(bool weights = false, bool exist = true, size_t threads = 1) :
+            Dualizer(branching_strategy(weights), exist, threads) {}
+
+    /*! Branches on the rows a copy of strategy chooses*/
+    explicit Dualizer(const BranchingStrategy &strategy, bool exist = true,
+                      size_t threads = 1) :
+            strategy(strategy.clone()), exist(exist), threads(max<size_t>(threads, 1)),
+            count(0) {}
+
+    BranchingStrategy &getStrategy() const {
+        return *strategy;
+    }
+
+    bool getExist() const {
+        return exist;
+    }
+
+    void setExist(bool value) {
+        exist = value;
+    }
+
+    size_t getThreads() const {
+        return threads;
+    }
+
+    size_t getCount() const {
+        return count;
+    }
+
+    CoverageStore &getCoverages() {
+        return coverages;
+    }
+
+    set<pair<set<size_t>, set<size_t>>> &getFound_coverages() {
+        return found_coverages;
+    }
+
+    /*! Forgets the count and the saved results*/
+    void clear() {
+        count = 0;
+        coverages.clear();
+        found_coverages.clear();
+    }
+
+    /**
+     * Prints the irredundant coverages of L1 or, with save set, adds them to
+     * getCoverages(), which are then sorted by their words.
+     */
+    void dualization(PartialBitMatrix &L1, bool save = false) {
+        PrintVisitor printer;
+        if (save) {
+            dualization(L1, coverages);
+        } else if (threads <= 1) {
+            ::dualization(L1, printer, *strategy);
+        } else {
+            CoverageStore result;
+            dualization(L1, result);
+            for (BitsetView coverage: result) printer.visit(coverage);
+        }
+    }
+
+    /*! Adds the irredundant coverages of L1 to target and sorts it*/
+    void dualization(PartialBitMatrix &L1, CoverageStore &target) {
+        if (threads <= 1) {
+            SaveVisitor saver(&target, &found_coverages);
+            ::dualization(L1, saver, *strategy);
+        } else {
+            Search search(strategy.get(), nullptr);
+            PartialBitMatrix unused;
+            void (*step)(PartialBitMatrix &, PartialBitMatrix &, Search &) = dualization_step;
+            parallel_collect(L1, unused, search, threads, target, found_coverages, step);
+        }
+        target.sort();
+    }
+
+    /*! Prints and counts the pairs of D1_dualization or, with save set, saves them*/
+    void D1_dualization(PartialBitMatrix &L1, PartialBitMatrix &L2, bool save = false) {
+        pairs(L1, L2, save ? &found_coverages : nullptr,
+              [](PartialBitMatrix &A, PartialBitMatrix &B, CoverageVisitor &visitor,
+                 BranchingStrategy &strategy) {
+                  ::D1_dualization(A, B, visitor, strategy);
+              }, D1_step);
+    }
+
+    /*! Prints and counts the pairs of D2_dualization or, with save set, saves them*/
+    void D2_dualization(PartialBitMatrix &L1, PartialBitMatrix &L2, bool save = false) {
+        pairs(L1, L2, save ? &found_coverages : nullptr,
+              [](PartialBitMatrix &A, PartialBitMatrix &B, CoverageVisitor &visitor,
+                 BranchingStrategy &strategy) {
+                  ::D2_dualization(A, B, visitor, strategy);
+              }, D2_step);
+    }
+
+    /*! Prints, if print is set, and counts the pairs of combine*/
+    void combine(CoverageStore &cov1, CoverageStore &cov2, bool print = true) {
+        PrintVisitor printer(&count, print);
+        ::combine(cov1, cov2, printer, exist);
+    }
+
+    void combine(CoverageStore &cov1, CoverageStore &cov2, CoverageVisitor &visitor,
+                 SearchControl *control = nullptr) {
+        ::combine(cov1, cov2, visitor, exist, control);
+    }
+
+    count_t combine_count(CoverageStore &cov1, CoverageStore &cov2,
+                          SearchControl *control = nullptr) {
+        return ::combine_count(cov1, cov2, exist, threads, control);
+    }
+};
+
+enum Engine {
+    ENGINE_DUALIZATION,
+    ENGINE_D1,
+    ENGINE_D2,
+};
+
+/**
+ * Header of a checkpoint file of CoverageEnumerator, followed by three LEB128
+ * varints per frame of the stack: next1, next2 and col1 + 1 (0 for none).
+ */
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t engine;
+    /*! 0 before the first result was asked for, 1 while running, 2 at the end*/
+    uint32_t status;
+    uint64_t fingerprint1;
+    uint64_t fingerprint2;
+    uint64_t nodes;
+    uint64_t results;
+    uint64_t frames;
+    char strategy[32];
+};
+
+const char CHECKPOINT_FILE_MAGIC[8] = {'D', 'U', 'A', 'L', 'C', 'K', 'P', '2'};
+
+/**
+ * Iterative form of dualization, D1_dualization and D2_dualization that
+ * hands out the results one at a time. The matrices are changed in place as
+ * in the recursive engines; the rest of the search is an explicit stack of
+ * frames, one per node on the way from the root, with the candidate columns
+ * of the node and the next one to try. The results come in the order of the
+ * recursive engines on one thread and stay valid until the next call of
+ * next(). The consumer may stop at any time: the matrices get back to their
+ * state at the start when the enumerator is destroyed.
+ *
+ * The search can be saved to a checkpoint file between two results, or
+ * periodically while it runs, and continued from the file by an enumerator
+ * over the same matrices. A frame is saved as the position of its cursors
+ * only: the resumed enumerator replays the selections on the path, so the
+ * strategy has to choose rows by the state of the matrices alone, which
+ * RandomRowStrategy does not.
+ */
+class CoverageEnumerator {
+    enum : size_t { NONE = SIZE_MAX };
+    /*! Number of nodes between two looks at the clock for checkpoints*/
+    enum : size_t { CHECKPOINT_PERIOD = 1 << 12 };
+
+    struct Frame {
+        /*! Marks of L1 and L2 and length of the search path to return to
+         * before the next branch, past the columns excluded so far*/
+        size_t mark1, mark2;
+        size_t depth;
+        /*! In D2, the same before the columns of L2 were excluded*/
+        size_t start2, depth1;
+        /*! Candidates below these are excluded*/
+        size_t excluded1, excluded2;
+        /*! Candidate columns; in D2 branches2 holds those of L2*/
+        BitsetView branches1, branches2;
+        /*! Next candidates to try and, in D2, the column of L1 being paired*/
+        size_t next1, next2, col1;
+        /*! Matrix the node branches in: 0 for L1, 1 for L2, 2 for both*/
+        int side;
+    };
+
+    Engine engine;
+    PartialBitMatrix *L1;
+    PartialBitMatrix *L2;
+    PartialBitMatrix empty;
+    Search search;
+    vector<Frame> stack;
+    size_t root1, root2;
+    /*! Hashes of the states of L1 and L2 at the start*/
+    ull state1, state2;
+    bool started, finished;
+    /*! Number of results handed out*/
+    size_t results;
+    /*! File of the periodic checkpoints, empty if there are none*/
+    string checkpoint;
+    chrono::steady_clock::duration period;
+    chrono::steady_clock::time_point saved;
+    /*! Number of nodes at which to look at the clock next*/
+    size_t check;
+
+    static size_t next_column(const BitsetView &columns, size_t from) {
+        return *BitsetView::iterator(columns.words(), columns.size(), from);
+    }
+
+    /**
+     * Visits the node the last selection led to. Returns true if it is a
+     * result to hand out; otherwise pushes the frame of its branches.
+     */
+    bool open() {
+        if (!search.enter()) {
+            finished = true;
+            return false;
+        }
+        bool empty1 = L1->getCur_height() == 0, empty2 = L2->getCur_height() == 0;
+        if (empty1 && empty2) {
+            SEARCH_STATS(search.leaf(L1->getSelected_cols().count() +
+                                     L2->getSelected_cols().count()));
+            if (search.admit()) return true;
+            finished = true;
+            return false;
+        }
+        Frame frame;
+        frame.mark1 = L1->mark();
+        frame.mark2 = L2->mark();
+        frame.depth = frame.depth1 = search.path.size();
+        frame.start2 = frame.mark2;
+        frame.excluded1 = frame.excluded2 = 0;
+        frame.next1 = frame.next2 = 0;
+        frame.col1 = NONE;
+        size_t row1 = 0, row2 = 0;
+        bool first;
+        if (engine == ENGINE_DUALIZATION) {
+            frame.side = 0;
+            frame.branches1 = L1->branch_columns(search.strategy->choose(*L1).first);
+        } else if (engine == ENGINE_D1) {
+            tie(row1, first) = D1_branch(*L1, *L2, search);
+            frame.side = first ? 0 : 1;
+            frame.branches1 = (first ? L1 : L2)->branch_columns(row1);
         } else {
-            for (size_t col2: one_cols2) {
-                if (L1.getSelected_cols().find(col2) !=
-                    L1.getSelected_cols().end())
+            if (!empty1) row1 = search.strategy->choose(*L1).first;
+            if (!empty2) row2 = search.strategy->choose(*L2).first;
+            frame.side = empty1 ? 1 : empty2 ? 0 : 2;
+            frame.branches1 = empty1 ? L2->branch_columns(row2) : L1->branch_columns(row1);
+            if (frame.side == 2) frame.branches2 = L2->branch_columns(row2);
+        }
+        stack.push_back(frame);
+        return false;
+    }
+
+    /**
+     * Excludes the candidates of columns from excluded up to col from the
+     * matrix side, as the recursive engines do after each branch, and moves
+     * the marks of frame past them.
+     */
+    void exclude(Frame &frame, int side, const BitsetView &columns, size_t &excluded,
+                 size_t col) {
+        for (size_t k = next_column(columns, excluded); k < col; k = next_column(columns, k + 1))
+            search.exclude(side ? *L2 : *L1, side, k);
+        excluded = max(excluded, col);
+        frame.mark1 = L1->mark();
+        frame.mark2 = L2->mark();
+        frame.depth = search.path.size();
+    }
+
+    /*! Pairs col of L1 with the columns of L2 from the first one on in D2*/
+    void pair_column(Frame &frame, size_t col) {
+        L2->rollback(frame.start2);
+        search.path.resize(frame.depth1);
+        exclude(frame, 0, frame.branches1, frame.excluded1, col);
+        frame.start2 = frame.mark2;
+        frame.depth1 = frame.depth;
+        frame.excluded2 = 0;
+        frame.col1 = col;
+        frame.next1 = col + 1;
+        frame.next2 = 0;
+    }
+
+    /*! Selects the next branch of frame. Returns false if there is none left*/
+    bool advance(Frame &frame) {
+        L1->rollback(frame.mark1);
+        L2->rollback(frame.mark2);
+        search.path.resize(frame.depth);
+        if (frame.side != 2) {
+            PartialBitMatrix &L = frame.side ? *L2 : *L1;
+            const PartialBitMatrix &other = frame.side ? *L1 : *L2;
+            const BitsetView &branches = frame.branches1;
+            for (size_t col = next_column(branches, frame.next1); col < branches.size();
+                 col = next_column(branches, col + 1)) {
+                if (engine != ENGINE_DUALIZATION && other.getSelected_cols().in(col))
                     continue;
-                if (check_support_rows(L2, supporting_rows2, col2)) {
-                    supporting_rows2_new = update_support_rows(L2,
-                                                               supporting_rows2,
-                                                               col2);
-                    L2_new = L2;
-                    for (size_t i = 0; i < L2.getHeight(); i++) {
-                        if (L2.at(i, col2)) L2_new.delete_row(i);
-                    }
-                    L2_new.delete_column(col2);
-                    L2_new.update_matrix();
-                    D2_dualization(L1, L2_new, supporting_rows1,
-                                   supporting_rows2_new, weights, save,
-                                   found_coverages);
+                if (search.supported(L, col)) {
+                    exclude(frame, frame.side, branches, frame.excluded1, col);
+                    frame.next1 = col + 1;
+                    search.path.emplace_back(frame.side, col);
+                    search.select(L, col);
+                    return true;
+                }
+            }
+            return false;
+        }
+        while (true) {
+            if (frame.col1 == NONE) {
+                size_t col = next_column(frame.branches1, frame.next1);
+                while (col < frame.branches1.size() &&
+                       (L2->getSelected_cols().in(col) || !search.supported(*L1, col)))
+                    col = next_column(frame.branches1, col + 1);
+                if (col == frame.branches1.size()) return false;
+                pair_column(frame, col);
+            }
+            for (size_t col2 = next_column(frame.branches2, frame.next2);
+                 col2 < frame.branches2.size();
+                 col2 = next_column(frame.branches2, col2 + 1)) {
+                if (col2 == frame.col1 || L1->getSelected_cols().in(col2)) continue;
+                if (search.supported(*L2, col2)) {
+                    exclude(frame, 1, frame.branches2, frame.excluded2, col2);
+                    frame.next2 = col2 + 1;
+                    search.path.emplace_back(0, frame.col1);
+                    search.path.emplace_back(1, col2);
+                    search.select(*L1, frame.col1);
+                    search.select(*L2, col2);
+                    return true;
                 }
             }
+            frame.col1 = NONE;
         }
     }
-}
 
-void print_results(set<pair<set<size_t>, set<size_t>>> &found_coverages) {
-    for (auto &cov_pair: found_coverages) {
-        printf("{");
-        for (auto entry: cov_pair.first) {
-            printf("%ld ", entry);
+    /*! Moves to the next result. Returns false when there is none left*/
+    bool step() {
+        if (finished) return false;
+        if (!started) {
+            started = true;
+            if (open()) return true;
         }
-        printf("}  {");
-        for (auto entry: cov_pair.second) {
-            printf("%ld ", entry);
+        while (!finished && !stack.empty()) {
+            if (!checkpoint.empty() && search.nodes >= check) {
+                check = search.nodes + CHECKPOINT_PERIOD;
+                if (chrono::steady_clock::now() - saved >= period) save(checkpoint);
+            }
+            if (!advance(stack.back())) {
+                stack.pop_back();
+                continue;
+            }
+            if (open()) return true;
+            if (search.stopped()) break;
         }
-        printf("}\n");
+        finish();
+        return false;
     }
-}
 
-void
-dualization(PartialBitMatrix &L1, map<size_t, set<size_t>> &supporting_rows1,
-            bool weights = false, \
-    bool save = false, set<customset> &coverages = default_coverage) {
-    //cout << "FIRST:" << L1 << endl << endl;
-    PartialBitMatrix L_new(L1);
-    map<size_t, set<size_t>> supporting_rows_new;
-    bool L1_empty;
-    size_t row_number;
+    /*! Fingerprints of L1 and L2 as they were at the start*/
+    pair<ull, ull> fingerprints() const {
+        return {L1->fingerprint() ^ state1, L2->fingerprint() ^ state2};
+    }
 
-    L1_empty = L1.getCur_height() == 0;
-    if (L1_empty) {
-        if (save) {
-            coverages.insert(customset(L1.getSelected_cols(), L1.getWidth()));
+    static void put_varint(vector<unsigned char> &bytes, uint64_t value) {
+        do {
+            bytes.push_back((unsigned char) ((value & 0x7F) | (value > 0x7F ? 0x80 : 0)));
+            value >>= 7;
+        } while (value);
+    }
+
+    static uint64_t get_varint(const unsigned char *&data, const unsigned char *end) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64 && data < end; shift += 7) {
+            unsigned char byte = *data++;
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw runtime_error("Malformed checkpoint file");
+    }
+
+    /**
+     * Puts the frame of the node at the end of the path back on the stack
+     * and selects the branch saved in next1, next2 and col1. A frame without
+     * a branch started is only pushed.
+     */
+    void replay(size_t next1, size_t next2, size_t col1) {
+        if (open() || finished)
+            throw runtime_error("Checkpoint does not match the search");
+        Frame &frame = stack.back();
+        if (next1 == 0 && col1 == NONE) return;
+        if (frame.side != 2 && next1 > 0 && col1 == NONE && next2 == 0) {
+            frame.next1 = next1 - 1;
+        } else if (frame.side == 2 && col1 < frame.branches1.size() &&
+                   frame.branches1.in(col1) && next1 == col1 + 1 &&
+                   next2 > 0) {
+            pair_column(frame, col1);
+            frame.next2 = next2 - 1;
         } else {
-            printf("{");
-            for (auto entry: L1.getSelected_cols()) {
-                printf("%ld ", entry);
-            }
-            printf("}\n");
+            throw runtime_error("Checkpoint does not match the search");
         }
-        return;
+        if (!advance(frame) || frame.next1 != next1 || frame.next2 != next2 || frame.col1 != col1)
+            throw runtime_error("Checkpoint does not match the search");
     }
-    if (weights) {
-        row_number = L1.getLightestRow().first;
-    } else {
-        row_number = *L1.getAvailable_rows().begin();
-    }
-    for (size_t col: L1.getAvailable_cols()) {
-        if (L1.at(row_number, col)) {
-            if (check_support_rows(L1, supporting_rows1, col)) {
-                supporting_rows_new = update_support_rows(L1, supporting_rows1,
-                                                          col);
-                L_new = L1;
-                for (size_t i = 0; i < L1.getHeight(); i++) {
-                    if (L1.at(i, col)) L_new.delete_row(i);
-                }
-                L_new.delete_column(col);
-                L_new.update_matrix();
-                dualization(L_new, supporting_rows_new, weights, save,
-                            coverages);
+
+    /*! Gives the matrices back their state at the start*/
+    void finish() {
+        finished = true;
+        stack.clear();
+        search.path.clear();
+        L1->rollback(root1);
+        L2->rollback(root2);
+    }
+
+public:
+    /*! Enumerates the irredundant coverages of L1 as dualization does*/
+    CoverageEnumerator(PartialBitMatrix &L1, BranchingStrategy &strategy,
+                       SearchControl *control = nullptr) :
+            CoverageEnumerator(L1, L1, ENGINE_DUALIZATION, strategy, control) {}
+
+    /**
+     * Enumerates the results of engine on L1 and L2; ENGINE_DUALIZATION
+     * ignores L2. The frame stack is sized for the deepest possible path.
+     */
+    CoverageEnumerator(PartialBitMatrix &L1, PartialBitMatrix &L2, Engine engine,
+                       BranchingStrategy &strategy, SearchControl *control = nullptr) :
+            engine(engine), L1(&L1), L2(&L2), search(&strategy, nullptr, control),
+            started(false), finished(false), results(0), check(0) {
+        if (engine == ENGINE_DUALIZATION) this->L2 = &empty;
+        if (engine != ENGINE_DUALIZATION && L1.getWidth() != L2.getWidth()) {
+            cerr << "Matrices should be of equal width" << endl;
+            throw length_error("");
+        }
+        stack.reserve(this->L1->getWidth() + this->L2->getWidth() + 1);
+        root1 = this->L1->mark();
+        root2 = this->L2->mark();
+        state1 = this->L1->state_hash(0);
+        state2 = this->L2->state_hash(0);
+    }
+
+    CoverageEnumerator(const CoverageEnumerator &) = delete;
+
+    CoverageEnumerator &operator=(const CoverageEnumerator &) = delete;
+
+    ~CoverageEnumerator() {
+        if (started && !finished) finish();
+    }
+
+    /*! Next coverage, the one of L1 in D1 and D2. Returns false at the end*/
+    bool next(BitsetView &coverage) {
+        if (!step()) return false;
+        results++;
+        coverage = L1->getSelected_cols();
+        return true;
+    }
+
+    /*! Next pair of coverages of L1 and L2. Returns false at the end*/
+    bool next(BitsetView &first, BitsetView &second) {
+        if (!step()) return false;
+        results++;
+        first = L1->getSelected_cols();
+        second = L2->getSelected_cols();
+        return true;
+    }
+
+    /*! Number of nodes of the search tree visited so far*/
+    size_t getNodes() const {
+        return search.nodes;
+    }
+
+    /*! Number of results handed out so far, counting those before a resume*/
+    size_t getResults() const {
+        return results;
+    }
+
+    /**
+     * Saves the search to filename every seconds seconds while next() runs.
+     * The clock is read once every CHECKPOINT_PERIOD nodes. A save writes a
+     * few bytes per level of the path but waits for the disk in fsync, so
+     * periods of a minute or so keep its cost far below a percent of the
+     * run. An empty filename turns the checkpoints off.
+     */
+    void setCheckpoint(const string &filename, double seconds) {
+        checkpoint = filename;
+        period = chrono::duration_cast<chrono::steady_clock::duration>(
+                chrono::duration<double>(seconds));
+        saved = chrono::steady_clock::now();
+        check = search.nodes;
+    }
+
+    /**
+     * Writes the position of the search to filename: the cursors of every
+     * frame, the counters and the fingerprints of the matrices. The file is
+     * written next to filename and renamed over it, so a crash while saving
+     * leaves the previous checkpoint in place.
+     */
+    void save(const string &filename) {
+        CheckpointHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CHECKPOINT_FILE_MAGIC, sizeof(header.magic));
+        header.engine = engine;
+        header.status = !started ? 0 : finished ? 2 : 1;
+        tie(header.fingerprint1, header.fingerprint2) = fingerprints();
+        header.nodes = search.nodes;
+        header.results = results;
+        header.frames = finished ? 0 : stack.size();
+        strncpy(header.strategy, search.strategy->name(), sizeof(header.strategy) - 1);
+        vector<unsigned char> bytes((unsigned char *) &header,
+                                    (unsigned char *) &header + sizeof(header));
+        for (size_t i = 0; i < header.frames; i++) {
+            put_varint(bytes, stack[i].next1);
+            put_varint(bytes, stack[i].next2);
+            put_varint(bytes, stack[i].col1 + 1);
+        }
+        string temporary = filename + ".tmp";
+        FILE *out = fopen(temporary.c_str(), "wb");
+        if (out == nullptr) {
+            cerr << "Error: " << strerror(errno) << endl;
+            cerr << "Failed to open checkpoint file" << endl;
+            throw bad_exception();
+        }
+        bool written = fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size() &&
+                       fflush(out) == 0 && fsync(fileno(out)) == 0;
+        if (fclose(out) != 0) written = false;
+        if (!written || rename(temporary.c_str(), filename.c_str()) != 0) {
+            cerr << "Error: " << strerror(errno) << endl;
+            throw runtime_error("Failed to write checkpoint file");
+        }
+        saved = chrono::steady_clock::now();
+    }
+
+    /**
+     * Continues the search saved to filename, before the first call of
+     * next(). The results handed out before the save are not repeated. The
+     * matrices, the engine and the strategy have to be those of the saved
+     * search; a mismatch throws runtime_error.
+     */
+    void resume(const string &filename) {
+        if (started) {
+            cerr << "Resume has to come before the first result" << endl;
+            throw logic_error("");
+        }
+        ifstream in(filename, ios::binary);
+        if (!in) {
+            cerr << "Error: " << strerror(errno) << endl;
+            cerr << "Failed to open checkpoint file" << endl;
+            throw bad_exception();
+        }
+        vector<unsigned char> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        CheckpointHeader header;
+        if (bytes.size() < sizeof(header) ||
+            memcmp(bytes.data(), CHECKPOINT_FILE_MAGIC, sizeof(header.magic)) != 0)
+            throw runtime_error("Not a checkpoint file: " + filename);
+        memcpy(&header, bytes.data(), sizeof(header));
+        header.strategy[sizeof(header.strategy) - 1] = 0;
+        if (header.engine != (uint32_t) engine || header.status > 2 ||
+            strncmp(header.strategy, search.strategy->name(), sizeof(header.strategy) - 1) != 0 ||
+            header.frames > stack.capacity() ||
+            make_pair(header.fingerprint1, header.fingerprint2) != fingerprints()) {
+            cerr << "Checkpoint " << filename << " was saved by another search" << endl;
+            throw runtime_error("Checkpoint does not match the search");
+        }
+        if (header.status == 0) return;
+        started = true;
+        const unsigned char *data = bytes.data() + sizeof(header), *end = bytes.data() + bytes.size();
+        try {
+            for (uint64_t i = 0; i < header.frames && header.status == 1; i++) {
+                size_t next1 = get_varint(data, end);
+                size_t next2 = get_varint(data, end);
+                size_t col1 = get_varint(data, end) - 1;
+                replay(next1, next2, col1);
             }
+        } catch (...) {
+            finish();
+            throw;
+        }
+        if (header.status == 2) finish();
+        search.nodes = header.nodes;
+        results = header.results;
+        check = search.nodes;
+    }
+};
+
+/*! Result of one job of a batch*/
+struct BatchResult {
+    /*! Coverages found by dualization, if they were saved*/
+    CoverageStore coverages;
+    /*! Pairs found by D1 or D2, if they were saved*/
+    set<pair<set<size_t>, set<size_t>>> found_coverages;
+    /*! Number of results the engine passed on, as its count function gives*/
+    count_t count;
+    /*! Number of nodes of the search tree*/
+    size_t nodes;
+
+    BatchResult() : count(0), nodes(0) {}
+};
+
+/*! Counts the results of a batch job and saves them if save is set*/
+class BatchVisitor : public CoverageVisitor {
+public:
+    BatchResult *result;
+    bool save;
+
+    explicit BatchVisitor(bool save) : result(nullptr), save(save) {}
+
+    void visit(const BitsetView &coverage) override {
+        result->count++;
+        if (save) result->coverages.insert(coverage);
+    }
+
+    void visit(const BitsetView &first, const BitsetView &second) override {
+        result->count++;
+        if (save) result->found_coverages.insert({first.to_set(), second.to_set()});
+    }
+};
+
+/**
+ * Runs work(job, search, visitor, scratch) for every job on threads workers.
+ * The jobs are taken from a shared counter in the order of decreasing cost,
+ * so the long ones start first and the short ones fill the gaps at the end. A
+ * worker keeps its Search, its copy of strategy, its visitor and a pair of
+ * scratch matrices for all of its jobs; between two jobs only the path and
+ * the count of the search are reset, and a job resets the scratch matrices
+ * from its own with PartialBitMatrix::reset, which keeps their buffers. The
+ * nodes of the search add up over the jobs, so that the profile of control
+ * gets the totals of every worker; a job takes its own nodes as the
+ * difference. control, if given, is shared by all jobs: once it stops a run,
+ * the jobs not started yet are skipped and keep empty results.
+ */
+template<class Work>
+void run_batch(const vector<size_t> &costs, BranchingStrategy &strategy,
+               size_t threads, bool save, SearchControl *control, Work work) {
+    vector<size_t> order(costs.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return costs[a] > costs[b];
+    });
+    threads = max<size_t>(1, min(threads, order.size()));
+    atomic<size_t> next_job(0);
+
+    auto worker = [&](size_t) {
+        unique_ptr<BranchingStrategy> own = strategy.clone();
+        BatchVisitor visitor(save);
+        pair<PartialBitMatrix, PartialBitMatrix> scratch;
+        Search search(own.get(), nullptr, control);
+        for (size_t k; (k = next_job++) < order.size();) {
+            if (search.stopped()) break;
+            search.path.clear();
+            search.count = 0;
+            work(order[k], search, visitor, scratch);
+        }
+    };
+
+    vector<thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(worker, t);
+    worker(0);
+    for (auto &w: workers) w.join();
+}
+
+/**
+ * Dualizes every matrix of a batch on one set of threads, each matrix on one
+ * thread, and returns the results in the order of matrices. With save set
+ * the coverages are kept in the results, otherwise they are only counted.
+ * This pays off for many small matrices, where one of them is too small to
+ * share between threads. The matrices are not modified. control, if given,
+ * limits the whole batch.
+ */
+inline vector<BatchResult> batch_dualization(const vector<PartialBitMatrix> &matrices,
+                                             BranchingStrategy &strategy,
+                                             size_t threads = 1, bool save = false,
+                                             SearchControl *control = nullptr) {
+    vector<BatchResult> results(matrices.size());
+    vector<size_t> costs;
+    for (auto &L: matrices) costs.push_back(L.getCur_height() * L.getCur_width());
+    run_batch(costs, strategy, threads, save, control,
+              [&](size_t i, Search &search, BatchVisitor &visitor,
+                  pair<PartialBitMatrix, PartialBitMatrix> &scratch) {
+                  size_t start = search.nodes;
+                  scratch.first.reset(matrices[i]);
+                  visitor.result = &results[i];
+                  search.visitor = save ? &visitor : nullptr;
+                  dualization_step(scratch.first, search);
+                  if (save) results[i].coverages.sort();
+                  else results[i].count = search.count;
+                  results[i].nodes = search.nodes - start;
+              });
+    return results;
+}
+
+/**
+ * Runs D1 or D2 on every pair of matrices of a batch as batch_dualization
+ * does. Without save the pairs of D1 are counted as D1_count does.
+ */
+inline vector<BatchResult> batch_dualization(
+        const vector<pair<PartialBitMatrix, PartialBitMatrix>> &pairs, Engine engine,
+        BranchingStrategy &strategy, size_t threads = 1, bool save = false,
+        SearchControl *control = nullptr) {
+    if (engine == ENGINE_DUALIZATION) {
+        cerr << "Pairs of matrices need ENGINE_D1 or ENGINE_D2" << endl;
+        throw invalid_argument("");
+    }
+    vector<BatchResult> results(pairs.size());
+    vector<size_t> costs;
+    for (auto &job: pairs) {
+        if (job.first.getWidth() != job.second.getWidth()) {
+            cerr << "Matrices should be of equal width" << endl;
+            throw length_error("");
         }
+        costs.push_back((job.first.getCur_height() + job.second.getCur_height()) *
+                        job.first.getCur_width());
     }
+    run_batch(costs, strategy, threads, save, control,
+              [&](size_t i, Search &search, BatchVisitor &visitor,
+                  pair<PartialBitMatrix, PartialBitMatrix> &scratch) {
+                  PartialBitMatrix &L1 = scratch.first, &L2 = scratch.second;
+                  size_t start = search.nodes;
+                  L1.reset(pairs[i].first);
+                  L2.reset(pairs[i].second);
+                  visitor.result = &results[i];
+                  search.visitor = save ? &visitor : nullptr;
+                  if (engine == ENGINE_D2) D2_step(L1, L2, search);
+                  else if (save) D1_step(L1, L2, search);
+                  else search.count = D1_count_step(L1, L2, search, nullptr, false);
+                  if (!save) results[i].count = search.count;
+                  results[i].nodes = search.nodes - start;
+              });
+    return results;
 }
 
-void combine(set<customset> &cov1, set<customset> &cov2, bool print = true) {
-    for (auto &set1: cov1) {
-        for (auto &set2: cov2) {
-            if (check_intersection(set1, set2)) {
-                cov_count++;
-                if (print) {
-                    printf("{");
-                    for (size_t i = 0; i < set1.sz; i++) {
-                        if (set1.in(i)) printf("%ld ", i);
-                    }
-                    printf("}  {");
-                    for (size_t i = 0; i < set2.sz; i++) {
-                        if (set2.in(i)) printf("%ld ", i);
-                    }
-                    printf("}\n");
-                }
-                if (MODE) break;
-            }
+/*! Result of one run of compare_strategies*/
+struct StrategyReport {
+    string strategy;
+    size_t nodes;
+    size_t coverages;
+    double seconds;
+};
+
+/**
+ * Runs engine with every strategy on the same L1 (and L2 for D1 and D2) and
+ * reports the size of the search tree, the number of coverages or pairs
+ * passed to the visitor and the wall time of each run. The search reaches
+ * every coverage once, so the number found is the same for all strategies.
+ */
+inline vector<StrategyReport> compare_strategies(PartialBitMatrix &L1,
+                                                 PartialBitMatrix &L2, Engine engine,
+                                                 const vector<BranchingStrategy *> &strategies,
+                                                 size_t threads = 1) {
+    vector<StrategyReport> reports;
+    for (BranchingStrategy *strategy: strategies) {
+        CountVisitor counter;
+        size_t nodes = 0;
+        auto start = chrono::steady_clock::now();
+        switch (engine) {
+            case ENGINE_DUALIZATION:
+                nodes = dualization(L1, counter, *strategy, threads);
+                break;
+            case ENGINE_D1:
+                nodes = D1_dualization(L1, L2, counter, *strategy, threads);
+                break;
+            case ENGINE_D2:
+                nodes = D2_dualization(L1, L2, counter, *strategy, threads);
+                break;
         }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        reports.push_back({strategy->name(), nodes, counter.count, elapsed.count()});
+    }
+    return reports;
+}
+
+inline void print_reports(const vector<StrategyReport> &reports, ostream &out = cout) {
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << left << setw(20) << "strategy" << right << setw(14) << "nodes"
+        << setw(14) << "found" << setw(12) << "seconds" << setw(14)
+        << "nodes/s" << endl;
+    for (auto &report: reports) {
+        out << left << setw(20) << report.strategy << right << setw(14)
+            << report.nodes << setw(14) << report.coverages << setw(12)
+            << fixed << setprecision(4) << report.seconds << setw(14)
+            << setprecision(0) << (report.seconds > 0 ? report.nodes / report.seconds : 0.0)
+            << endl;
     }
+    out.flags(flags);
+    out.precision(precision);
 }
 
-void generate_matrix(size_t n, size_t m, const string &filename,
-                     double density = 0.5, int seed = -1) {
+inline void generate_matrix(size_t n, size_t m, const string &filename,
+                            double density = 0.5, int seed = -1) {
     if (seed != -1) srand(seed);
     ofstream out;
     out.open(filename);